@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+
+//! On-disk cache of linked contract binaries. An entry is keyed on everything which goes into
+//! the binary: the compiler itself, the target, the options, the contract name, and the path
+//! and contents of every file which was resolved for its namespace. A file which changes, or
+//! an import which now resolves to another file, gives a different key.
+//!
+//! The compiler is identified by a hash of its executable, which includes the stdlib bitcode.
+//! The version string alone is not enough, since a locally modified compiler or stdlib has
+//! the same version as the commit it was built from.
+
+use sha2::{Digest, Sha256};
+use solang::{codegen::Options, file_resolver::FileResolver, sema::ast::Namespace};
+use std::{
+    fs,
+    path::{Path, PathBuf},
+};
+
+pub struct Cache {
+    dir: PathBuf,
+    /// Hash of the compiler executable
+    compiler: String,
+}
+
+impl Cache {
+    /// Use the given directory for the cache. It is created if it does not exist yet. If it
+    /// cannot be created, or the compiler executable cannot be read, a warning is printed and
+    /// nothing is cached.
+    pub fn new(dir: &Path) -> Option<Self> {
+        if let Err(err) = fs::create_dir_all(dir) {
+            eprintln!(
+                "warning: cannot create cache directory {}: {err}",
+                dir.display()
+            );
+            return None;
+        }
+
+        let compiler = match std::env::current_exe().and_then(fs::read) {
+            Ok(exe) => hex::encode(Sha256::digest(exe)),
+            Err(err) => {
+                eprintln!("warning: cannot read compiler executable for the cache: {err}");
+                return None;
+            }
+        };
+
+        Some(Cache {
+            dir: dir.to_path_buf(),
+            compiler,
+        })
+    }
+
+    /// Compute the cache key for a contract
+    pub fn key(
+        &self,
+        ns: &Namespace,
+        resolver: &FileResolver,
+        contract_no: usize,
+        opt: &Options,
+    ) -> String {
+        let mut hasher = Sha256::new();
+
+        // every field is length prefixed, so that two different inputs never hash the same bytes
+        let mut field = |bytes: &[u8]| {
+            hasher.update((bytes.len() as u64).to_le_bytes());
+            hasher.update(bytes);
+        };
+
+        field(env!("SOLANG_VERSION").as_bytes());
+        field(self.compiler.as_bytes());
+        field(format!("{:?}", ns.target).as_bytes());
+        field(format!("{opt:?}").as_bytes());
+        field(ns.contracts[contract_no].id.name.as_bytes());
+
+        for file in &ns.files {
+            if let Some(contents) = file
+                .cache_no
+                .and_then(|cache_no| resolver.get_contents_of_file_no(cache_no))
+            {
+                field(file.path.as_os_str().as_encoded_bytes());
+                field(contents.as_bytes());
+            }
+        }
+
+        hex::encode(hasher.finalize())
+    }
+
+    pub fn get(&self, key: &str) -> Option<Vec<u8>> {
+        fs::read(self.dir.join(key)).ok()
+    }
+
+    /// Store the binary for a key. The entry is written to a temporary file and then renamed,
+    /// so that another compiler process never reads a partially written entry. Failing to
+    /// write an entry only prints a warning.
+    pub fn put(&self, key: &str, code: &[u8]) {
+        let res = tempfile::NamedTempFile::new_in(&self.dir).and_then(|mut file| {
+            std::io::Write::write_all(&mut file, code)?;
+            file.persist(self.dir.join(key)).map_err(|err| err.error)?;
+            Ok(())
+        });
+
+        if let Err(err) = res {
+            eprintln!(
+                "warning: cannot write cache entry in {}: {err}",
+                self.dir.display()
+            );
+        }
+    }
+}
@@ -178,6 +178,10 @@ impl Compile {
                 "VERBOSE" => {
                     self.compiler_output.verbose = *matches.get_one::<bool>("VERBOSE").unwrap()
                 }
+                "JOBS" => self.compiler_output.jobs = matches.get_one::<u64>("JOBS").copied(),
+                "CACHEDIR" => {
+                    self.compiler_output.cache_dir = matches.get_one::<PathBuf>("CACHEDIR").cloned()
+                }
 
                 // DebugFeatures args
                 "NOLOGRUNTIMEERRORS" => {
@@ -227,6 +231,9 @@ impl Compile {
                 "VALUE_LENGTH" => {
                     self.target_arg.value_length = matches.get_one::<u64>("VALUE_LENGTH").copied()
                 }
+                "HEAP-SIZE" => {
+                    self.target_arg.heap_size = matches.get_one::<u32>("HEAP-SIZE").copied()
+                }
 
                 _ => {}
             }
@@ -257,6 +264,14 @@ pub struct CompilerOutput {
     #[arg(name = "VERBOSE" ,help = "show debug messages", short = 'v', action = ArgAction::SetTrue, long = "verbose")]
     #[serde(default)]
     pub verbose: bool,
+
+    #[arg(name = "JOBS", help = "Number of source files to compile in parallel", short = 'j', long = "jobs", num_args = 1, value_parser = value_parser!(u64).range(1..))]
+    #[serde(default)]
+    pub jobs: Option<u64>,
+
+    #[arg(name = "CACHEDIR", help = "Directory for caching linked contracts between runs", long = "cache-dir", num_args = 1, value_parser = ValueParser::path_buf())]
+    #[serde(default)]
+    pub cache_dir: Option<PathBuf>,
 }
 
 #[derive(Args)]
@@ -281,6 +296,10 @@ pub struct CompileTargetArg {
 
     #[arg(name = "VALUE_LENGTH", help = "Value length on the Polkadot Parachain", long = "value-length", num_args = 1, value_parser = value_parser!(u64).range(4..1024))]
     pub value_length: Option<u64>,
+
+    #[arg(name = "HEAP-SIZE", help = "Heap size in bytes for Solana programs (a multiple of 1024 between 32768 and 262144)", long = "heap-size", num_args = 1, value_parser = ValueParser::new(parse_heap_size))]
+    #[serde(default, deserialize_with = "deserialize_heap_size")]
+    pub heap_size: Option<u32>,
 }
 
 #[derive(Args)]
@@ -563,6 +582,7 @@ pub fn options_arg(
     debug: &DebugFeatures,
     optimizations: &Optimizations,
     compiler_inputs: &CompilePackage,
+    target_arg: &CompileTargetArg,
 ) -> Options {
     let opt_level = if let Some(level) = &optimizations.opt_level {
         match level.as_str() {
@@ -594,6 +614,7 @@ pub fn options_arg(
             None
         }),
         soroban_version: compiler_inputs.soroban_version,
+        solana_heap_size: target_arg.heap_size,
     }
 }
 
@@ -615,6 +636,19 @@ fn parse_version(version: &str) -> Result<String, String> {
     }
 }
 
+/// Solana lets a transaction request a heap frame of up to 256 KiB, in 1 KiB increments
+fn check_heap_size(size: u32) -> Result<u32, String> {
+    if !(32 * 1024..=256 * 1024).contains(&size) || size % 1024 != 0 {
+        Err("heap size must be a multiple of 1024 between 32768 and 262144".to_owned())
+    } else {
+        Ok(size)
+    }
+}
+
+fn parse_heap_size(size: &str) -> Result<u32, String> {
+    check_heap_size(size.parse().map_err(|e| format!("{e}"))?)
+}
+
 fn deserialize_inline_table<'de, D>(
     deserializer: D,
 ) -> Result<Option<Vec<(String, PathBuf)>>, D::Error>
@@ -660,6 +694,21 @@ where
     }
 }
 
+fn deserialize_heap_size<'de, D>(deserializer: D) -> Result<Option<u32>, D::Error>
+where
+    D: serde::Deserializer<'de>,
+{
+    let res: Option<u32> = Option::deserialize(deserializer)?;
+
+    match res {
+        Some(size) => match check_heap_size(size) {
+            Ok(size) => Ok(Some(size)),
+            Err(err) => Err(serde::de::Error::custom(err)),
+        },
+        None => Ok(None),
+    }
+}
+
 fn deserialize_emit<'de, D>(deserializer: D) -> Result<Option<String>, D::Error>
 where
     D: serde::Deserializer<'de>,
@@ -34,6 +34,20 @@ mod tests {
             assert_eq!(compile_args.optimizations.opt_level.unwrap(), "aggressive");
         }
 
+        command = "solang compile flipper.sol --target solana --heap-size 65536"
+            .split(' ')
+            .collect();
+        cli = Cli::parse_from(command);
+
+        if let Commands::Compile(compile_args) = cli.command {
+            assert_eq!(compile_args.target_arg.heap_size, Some(65536));
+        }
+
+        assert!(Cli::try_parse_from(
+            "solang compile flipper.sol --target solana --heap-size 40000".split(' ')
+        )
+        .is_err());
+
         command = "solang compile flipper.sol --target polkadot --no-log-runtime-errors --no-prints -g --release".split(' ').collect();
         cli = Cli::parse_from(command);
 
@@ -111,7 +125,14 @@ mod tests {
             soroban_version: None,
         };
 
-        let opt = options_arg(&default_debug, &default_optimize, &compiler_package);
+        let compiler_target: cli::CompileTargetArg = toml::from_str("").unwrap();
+
+        let opt = options_arg(
+            &default_debug,
+            &default_optimize,
+            &compiler_package,
+            &compiler_target,
+        );
 
         assert_eq!(opt, Options::default());
 
@@ -154,6 +175,18 @@ mod tests {
         assert_eq!(target.name.unwrap(), "polkadot");
         assert_eq!(target.address_length.unwrap(), 32);
         assert_eq!(target.value_length.unwrap(), 16);
+        assert_eq!(target.heap_size, None);
+
+        let target: cli::CompileTargetArg = toml::from_str(
+            r#"
+        name = "solana"
+        heap_size = 65536"#,
+        )
+        .unwrap();
+
+        assert_eq!(target.heap_size, Some(65536));
+
+        assert!(toml::from_str::<cli::CompileTargetArg>("heap_size = 1000").is_err());
     }
 
     #[test]
@@ -164,6 +197,7 @@ mod tests {
         emit = "ast-dot"
         output_directory = "output"
         output_meta = "metadata"
+        jobs = 4
         "#;
 
         let out: cli::CompilerOutput = toml::from_str(compiler_out).unwrap();
@@ -173,11 +207,13 @@ mod tests {
         assert_eq!(out.emit, Some("ast-dot".to_owned()));
         assert_eq!(out.output_directory, Some("output".to_owned()));
         assert_eq!(out.output_meta, Some("metadata".to_owned()));
+        assert_eq!(out.jobs, Some(4));
 
         let default_out: cli::CompilerOutput = toml::from_str("").unwrap();
 
         assert!(!default_out.verbose);
         assert!(!default_out.std_json_output);
+        assert_eq!(default_out.jobs, None);
     }
 
     #[test]
@@ -196,19 +232,22 @@ mod tests {
                     import_map: Some(vec![]),
                     authors: None,
                     version: Some("0.1.0".to_string()),
-                    soroban_version: None
+                    soroban_version: None,
                 },
                 compiler_output: cli::CompilerOutput {
                     emit: None,
                     std_json_output: false,
                     output_directory: None,
                     output_meta: None,
-                    verbose: false
+                    verbose: false,
+                    jobs: None,
+                    cache_dir: None
                 },
                 target_arg: cli::CompileTargetArg {
                     name: Some("solana".to_owned()),
                     address_length: None,
-                    value_length: None
+                    value_length: None,
+                    heap_size: None
                 },
                 debug_features: cli::DebugFeatures {
                     log_runtime_errors: true,
@@ -252,19 +291,22 @@ mod tests {
                     import_map: Some(vec![]),
                     authors: Some(vec!["not_sesa".to_owned()]),
                     version: Some("0.1.0".to_string()),
-                    soroban_version: None
+                    soroban_version: None,
                 },
                 compiler_output: cli::CompilerOutput {
                     emit: None,
                     std_json_output: false,
                     output_directory: None,
                     output_meta: None,
-                    verbose: false
+                    verbose: false,
+                    jobs: None,
+                    cache_dir: None
                 },
                 target_arg: cli::CompileTargetArg {
                     name: Some("polkadot".to_owned()),
                     address_length: Some(33),
-                    value_length: Some(31)
+                    value_length: Some(31),
+                    heap_size: None
                 },
                 debug_features: cli::DebugFeatures {
                     log_runtime_errors: true,
@@ -20,9 +20,10 @@ use solang::{
 use solang_forge_fmt::{format_to, parse, FormatterConfig};
 use solang_parser::pt;
 use std::{
-    collections::{HashMap, HashSet},
+    collections::{hash_map::DefaultHasher, HashMap, HashSet},
     ffi::OsString,
-    path::PathBuf,
+    hash::{Hash, Hasher},
+    path::{Path, PathBuf},
 };
 use tokio::sync::Mutex;
 use tower_lsp::{
@@ -126,6 +127,62 @@ type Properties = HashMap<DefinitionIndex, HashMap<String, Option<DefinitionInde
 struct Files {
     caches: HashMap<PathBuf, FileCache>,
     text_buffers: HashMap<PathBuf, String>,
+    analyses: HashMap<PathBuf, Analysis>,
+}
+
+/// The files which made up the namespace when an opened file was last parsed, and a hash of
+/// their contents. If none of them changed since, and none of the paths where an import was
+/// looked up without finding a file exist now, parsing the file again gives the same result.
+struct Analysis {
+    files: Vec<PathBuf>,
+    missing: Vec<PathBuf>,
+    hash: u64,
+}
+
+impl Files {
+    /// The current contents of a file; the editor's buffer if it is open, else the file on disk
+    fn contents(&self, path: &Path) -> Option<String> {
+        match self.text_buffers.get(path) {
+            Some(text) => Some(text.clone()),
+            None => std::fs::read_to_string(path).ok(),
+        }
+    }
+
+    /// Is the namespace of the file unchanged since it was last parsed
+    fn unchanged(&self, path: &Path) -> bool {
+        let Some(analysis) = self.analyses.get(path) else {
+            return false;
+        };
+
+        // an import which was not found, or a file which would now also match an import
+        if analysis
+            .missing
+            .iter()
+            .any(|path| self.text_buffers.contains_key(path) || path.exists())
+        {
+            return false;
+        }
+
+        let mut hasher = DefaultHasher::new();
+
+        for file in &analysis.files {
+            match self.contents(file) {
+                Some(contents) => contents.hash(&mut hasher),
+                None => return false,
+            }
+        }
+
+        hasher.finish() == analysis.hash
+    }
+
+    /// The opened files, other than the given one, whose namespace includes the given file
+    fn dependents(&self, path: &Path) -> Vec<PathBuf> {
+        self.analyses
+            .iter()
+            .filter(|(top, analysis)| *top != path && analysis.files.iter().any(|f| f == path))
+            .map(|(top, _)| top.clone())
+            .collect()
+    }
 }
 
 #[derive(Debug)]
@@ -235,11 +292,22 @@ pub async fn start_server(language_args: &LanguageServerCommand) -> ! {
 }
 
 impl SolangServer {
-    /// Parse file
+    /// Parse file. Nothing is done if neither the file nor anything it imports has changed
+    /// since it was last parsed, since the diagnostics and caches would be the same.
     async fn parse_file(&self, uri: Url) {
         let mut resolver = FileResolver::default();
-        for (path, contents) in &self.files.lock().await.text_buffers {
-            resolver.set_file_contents(path.to_str().unwrap(), contents.clone());
+        {
+            let files = self.files.lock().await;
+
+            if let Ok(path) = uri.to_file_path() {
+                if files.unchanged(&path) {
+                    return;
+                }
+            }
+
+            for (path, contents) in &files.text_buffers {
+                resolver.set_file_contents(path.to_str().unwrap(), contents.clone());
+            }
         }
         if let Ok(path) = uri.to_file_path() {
             let dir = path.parent().unwrap();
@@ -311,6 +379,21 @@ impl SolangServer {
 
             let (file_caches, global_cache) = Builder::new(&ns).build();
 
+            // hash the contents which were parsed, so the next parse can be skipped if they are
+            // unchanged
+            let mut hasher = DefaultHasher::new();
+            let mut analysis_files = Vec::new();
+
+            for f in &ns.files {
+                if let Some(contents) = f
+                    .cache_no
+                    .and_then(|cache_no| resolver.get_contents_of_file_no(cache_no))
+                {
+                    contents.hash(&mut hasher);
+                    analysis_files.push(f.path.clone());
+                }
+            }
+
             let mut files = self.files.lock().await;
             for (f, c) in ns.files.iter().zip(file_caches.into_iter()) {
                 if f.cache_no.is_some() {
@@ -318,6 +401,15 @@ impl SolangServer {
                 }
             }
 
+            files.analyses.insert(
+                path,
+                Analysis {
+                    files: analysis_files,
+                    missing: resolver.get_missing_paths().to_vec(),
+                    hash: hasher.finish(),
+                },
+            );
+
             let mut gc = self.global_cache.lock().await;
             gc.extend(global_cache);
 
@@ -2194,7 +2286,19 @@ impl LanguageServer for SolangServer {
             }
         }
 
-        self.parse_file(uri).await;
+        self.parse_file(uri.clone()).await;
+
+        // Other opened files which import this one are only checked again on save, so
+        // that each change only parses the file being edited
+        if let Ok(path) = uri.to_file_path() {
+            let dependents = self.files.lock().await.dependents(&path);
+
+            for dependent in dependents {
+                if let Ok(uri) = Url::from_file_path(dependent) {
+                    self.parse_file(uri).await;
+                }
+            }
+        }
     }
 
     async fn did_close(&self, params: DidCloseTextDocumentParams) {
@@ -2204,6 +2308,7 @@ impl LanguageServer for SolangServer {
             let mut files = self.files.lock().await;
             files.caches.remove(&path);
             files.text_buffers.remove(&path);
+            files.analyses.remove(&path);
         }
 
         self.client.publish_diagnostics(uri, vec![], None).await;
@@ -3002,4 +3107,85 @@ mod test {
             ),
         );
     }
+
+    #[test]
+    fn unchanged_namespace() {
+        let a = PathBuf::from("/project/a.sol");
+        let b = PathBuf::from("/project/b.sol");
+
+        let mut files = Files::default();
+        files
+            .text_buffers
+            .insert(a.clone(), "contract A {}".to_string());
+        files
+            .text_buffers
+            .insert(b.clone(), "import \"a.sol\";".to_string());
+
+        let mut hasher = DefaultHasher::new();
+        "import \"a.sol\";".hash(&mut hasher);
+        "contract A {}".hash(&mut hasher);
+
+        files.analyses.insert(
+            b.clone(),
+            Analysis {
+                files: vec![b.clone(), a.clone()],
+                missing: Vec::new(),
+                hash: hasher.finish(),
+            },
+        );
+
+        assert!(files.unchanged(&b));
+        assert!(!files.unchanged(&a));
+        assert_eq!(files.dependents(&a), vec![b.clone()]);
+        assert!(files.dependents(&b).is_empty());
+
+        files
+            .text_buffers
+            .insert(a.clone(), "contract A { }".to_string());
+
+        assert!(!files.unchanged(&b));
+    }
+
+    #[test]
+    fn unchanged_namespace_missing_import() {
+        let dir = tempfile::tempdir().unwrap();
+        let b = dir.path().join("b.sol");
+        let c = dir.path().join("c.sol");
+        let d = dir.path().join("d.sol");
+
+        let mut files = Files::default();
+        files
+            .text_buffers
+            .insert(b.clone(), "import \"c.sol\";".to_string());
+
+        let mut hasher = DefaultHasher::new();
+        "import \"c.sol\";".hash(&mut hasher);
+
+        files.analyses.insert(
+            b.clone(),
+            Analysis {
+                files: vec![b.clone()],
+                missing: vec![c.clone(), d.clone()],
+                hash: hasher.finish(),
+            },
+        );
+
+        assert!(files.unchanged(&b));
+
+        // the import is found once the file is created on disk
+        std::fs::write(&c, "contract C {}").unwrap();
+
+        assert!(!files.unchanged(&b));
+
+        std::fs::remove_file(&c).unwrap();
+
+        assert!(files.unchanged(&b));
+
+        // or opened in the editor
+        files
+            .text_buffers
+            .insert(d.clone(), "contract D {}".to_string());
+
+        assert!(!files.unchanged(&b));
+    }
 }
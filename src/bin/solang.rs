@@ -5,6 +5,7 @@ use clap::{Command, CommandFactory, FromArgMatches};
 use clap_complete::generate;
 use cli::PackageTrait;
 use itertools::Itertools;
+use rayon::prelude::*;
 use solang::{
     abi,
     codegen::{codegen, Options},
@@ -22,11 +23,13 @@ use std::{
     process::exit,
 };
 
+use crate::cache::Cache;
 use crate::cli::{
     imports_arg, options_arg, target_arg, Cli, Commands, Compile, CompilerOutput, Doc, New,
     ShellComplete,
 };
 
+mod cache;
 mod cli;
 mod doc;
 mod idl;
@@ -174,18 +177,15 @@ fn compile(compile_args: &Compile) {
         eprintln!("info: Solang version {}", env!("SOLANG_VERSION"));
     }
 
-    let mut resolver = imports_arg(&compile_args.package);
-
     let compile_package = &compile_args.package;
 
     let opt = options_arg(
         &compile_args.debug_features,
         &compile_args.optimizations,
         compile_package,
+        &compile_args.target_arg,
     );
 
-    let mut namespaces = Vec::new();
-
     let mut errors = false;
 
     // Build a map of requested contract names, and a flag specifying whether it was found or not
@@ -195,29 +195,48 @@ fn compile(compile_args: &Compile) {
         HashSet::new()
     };
 
-    for filename in compile_args.package.get_input() {
-        // TODO: this could be parallelized using e.g. rayon
-        let ns = process_file(
-            filename,
-            &mut resolver,
-            target,
-            &compile_args.compiler_output,
-            &opt,
-        );
+    let resolver = imports_arg(&compile_args.package);
+
+    let jobs = compile_args.compiler_output.jobs.unwrap_or(1) as usize;
+
+    let pool = rayon::ThreadPoolBuilder::new()
+        .num_threads(jobs)
+        .build()
+        .expect("failed to create thread pool");
+
+    // Each file has its own copy of the resolver, so that the files can be processed in
+    // parallel. A namespace and everything generated from it stays on one thread.
+    let mut namespaces: Vec<(Namespace, FileResolver)> = pool.install(|| {
+        compile_args
+            .package
+            .get_input()
+            .par_iter()
+            .map(|filename| {
+                let mut resolver = resolver.clone();
+
+                let ns = process_file(
+                    filename,
+                    &mut resolver,
+                    target,
+                    &compile_args.compiler_output,
+                    &opt,
+                );
 
-        namespaces.push(ns);
-    }
+                (ns, resolver)
+            })
+            .collect()
+    });
 
     let mut json_contracts = HashMap::new();
 
     let std_json = compile_args.compiler_output.std_json_output;
 
-    for ns in &namespaces {
+    for (ns, resolver) in &namespaces {
         if std_json {
-            let mut out = ns.diagnostics_as_json(&resolver);
+            let mut out = ns.diagnostics_as_json(resolver);
             json.errors.append(&mut out);
         } else {
-            ns.print_diagnostics(&resolver, compile_args.compiler_output.verbose);
+            ns.print_diagnostics(resolver, compile_args.compiler_output.verbose);
         }
 
         if ns.diagnostics.any_errors() {
@@ -230,7 +249,7 @@ fn compile(compile_args: &Compile) {
     }
 
     // Ensure we have at least one contract
-    if !errors && namespaces.iter().all(|ns| ns.contracts.is_empty()) {
+    if !errors && namespaces.iter().all(|(ns, _)| ns.contracts.is_empty()) {
         eprintln!("error: no contacts found");
         errors = true;
     }
@@ -241,7 +260,7 @@ fn compile(compile_args: &Compile) {
         .filter(|name| {
             !namespaces
                 .iter()
-                .flat_map(|ns| ns.contracts.iter())
+                .flat_map(|(ns, _)| ns.contracts.iter())
                 .any(|contract| **name == contract.id.name)
         })
         .collect();
@@ -263,26 +282,65 @@ fn compile(compile_args: &Compile) {
             vec!["unknown".to_string()]
         };
 
+        if compile_args.target_arg.heap_size.is_some() && target != solang::Target::Solana {
+            eprintln!("warning: the `heap-size` flag will be ignored for {target} target")
+        }
+
         let version = if let Some(version) = &compile_args.package.version {
             version
         } else {
             "0.0.1"
         };
 
-        for ns in &mut namespaces {
-            for contract_no in 0..ns.contracts.len() {
-                contract_results(
-                    contract_no,
-                    &compile_args.compiler_output,
-                    ns,
-                    &mut json_contracts,
-                    &mut seen_contracts,
-                    &opt,
-                    &authors,
-                    version,
-                );
-            }
-        }
+        // Select the contracts before emitting any of them, so that duplicates are found in the
+        // same order however many jobs there are
+        let selected: Vec<Vec<usize>> = namespaces
+            .iter()
+            .map(|(ns, _)| {
+                (0..ns.contracts.len())
+                    .filter(|contract_no| {
+                        select_contract(
+                            *contract_no,
+                            &compile_args.compiler_output,
+                            ns,
+                            &mut seen_contracts,
+                        )
+                    })
+                    .collect()
+            })
+            .collect();
+
+        let cache = compile_args
+            .compiler_output
+            .cache_dir
+            .as_deref()
+            .and_then(Cache::new);
+
+        let results: Vec<Vec<(String, JsonContract)>> = pool.install(|| {
+            namespaces
+                .par_iter_mut()
+                .zip(selected)
+                .map(|((ns, resolver), contracts)| {
+                    contracts
+                        .into_iter()
+                        .filter_map(|contract_no| {
+                            contract_results(
+                                contract_no,
+                                &compile_args.compiler_output,
+                                ns,
+                                resolver,
+                                cache.as_ref(),
+                                &opt,
+                                &authors,
+                                version,
+                            )
+                        })
+                        .collect()
+                })
+                .collect()
+        });
+
+        json_contracts.extend(results.into_iter().flatten());
     }
 
     if std_json {
@@ -354,23 +412,18 @@ fn process_file(
     ns
 }
 
-fn contract_results(
+/// Should code be generated for the contract. This reports duplicate contracts and prints
+/// the cfg if requested.
+fn select_contract(
     contract_no: usize,
     compiler_output: &CompilerOutput,
-    ns: &mut Namespace,
-    json_contracts: &mut HashMap<String, JsonContract>,
+    ns: &Namespace,
     seen_contracts: &mut HashMap<String, String>,
-    opt: &Options,
-    default_authors: &[String],
-    version: &str,
-) {
-    let verbose = compiler_output.verbose;
-    let std_json = compiler_output.std_json_output;
-
+) -> bool {
     let resolved_contract = &ns.contracts[contract_no];
 
     if !resolved_contract.instantiable {
-        return;
+        return false;
     }
 
     if ns.top_file_no() != resolved_contract.loc.file_no() {
@@ -378,7 +431,7 @@ fn contract_results(
         // a.sol which imports b.sol, and b.sol defines contract B, then:
         // solang compile a.sol
         // should not write the results for contract B
-        return;
+        return false;
     }
 
     let loc = ns.loc_to_string(PathDisplay::FullPath, &resolved_contract.loc);
@@ -395,9 +448,31 @@ fn contract_results(
 
     if let Some("cfg") = compiler_output.emit.as_deref() {
         println!("{}", resolved_contract.print_cfg(ns));
-        return;
+        return false;
     }
 
+    true
+}
+
+/// Generate the binary and metadata for a contract. With standard json output, the json for
+/// the contract is returned rather than written. If there is a cache, the binary is taken from
+/// it when nothing which goes into it has changed.
+#[allow(clippy::too_many_arguments)]
+fn contract_results(
+    contract_no: usize,
+    compiler_output: &CompilerOutput,
+    ns: &mut Namespace,
+    resolver: &FileResolver,
+    cache: Option<&Cache>,
+    opt: &Options,
+    default_authors: &[String],
+    version: &str,
+) -> Option<(String, JsonContract)> {
+    let verbose = compiler_output.verbose;
+    let std_json = compiler_output.std_json_output;
+
+    let resolved_contract = &ns.contracts[contract_no];
+
     if verbose {
         if ns.target == solang::Target::Solana {
             eprintln!(
@@ -412,15 +487,39 @@ fn contract_results(
         );
     }
 
-    let context = inkwell::context::Context::create();
+    let name = resolved_contract.id.name.clone();
 
-    let bin = resolved_contract.binary(ns, &context, opt, contract_no);
+    // intermediates are never cached
+    let cached = cache
+        .filter(|_| compiler_output.emit.is_none())
+        .map(|cache| (cache, cache.key(ns, resolver, contract_no, opt)));
 
-    if save_intermediates(&bin, compiler_output) {
-        return;
-    }
+    let code = match cached.as_ref().and_then(|(cache, key)| cache.get(key)) {
+        Some(code) => {
+            if verbose {
+                eprintln!("info: Using cached binary for contract {name}");
+            }
 
-    let code = bin.code(Generate::Linked).expect("llvm build");
+            code
+        }
+        None => {
+            let context = inkwell::context::Context::create();
+
+            let bin = resolved_contract.binary(ns, &context, opt, contract_no);
+
+            if save_intermediates(&bin, compiler_output) {
+                return None;
+            }
+
+            let code = bin.code(Generate::Linked).expect("llvm build");
+
+            if let Some((cache, key)) = &cached {
+                cache.put(key, &code);
+            }
+
+            code
+        }
+    };
 
     #[cfg(feature = "wasm_opt")]
     if let Some(level) = opt.wasm_opt.filter(|_| ns.target.is_polkadot() && verbose) {
@@ -431,8 +530,8 @@ fn contract_results(
     }
 
     if std_json {
-        json_contracts.insert(
-            bin.name,
+        Some((
+            name,
             JsonContract {
                 abi: abi::ethereum::gen_abi(contract_no, ns),
                 ewasm: Some(EwasmContract {
@@ -440,20 +539,15 @@ fn contract_results(
                 }),
                 minimum_space: None,
             },
-        );
+        ))
     } else {
-        let bin_filename = output_file(
-            compiler_output,
-            &bin.name,
-            ns.target.file_extension(),
-            false,
-        );
+        let bin_filename = output_file(compiler_output, &name, ns.target.file_extension(), false);
 
         if verbose {
             eprintln!(
                 "info: Saving binary {} for contract {}",
                 bin_filename.display(),
-                bin.name
+                name
             );
         }
 
@@ -463,18 +557,20 @@ fn contract_results(
 
         let (metadata, meta_ext) =
             abi::generate_abi(contract_no, ns, &code, verbose, default_authors, version);
-        let meta_filename = output_file(compiler_output, &bin.name, meta_ext, true);
+        let meta_filename = output_file(compiler_output, &name, meta_ext, true);
 
         if verbose {
             eprintln!(
                 "info: Saving metadata {} for contract {}",
                 meta_filename.display(),
-                bin.name
+                name
             );
         }
 
         let mut file = create_file(&meta_filename);
         file.write_all(metadata.as_bytes()).unwrap();
+
+        None
     }
 }
 
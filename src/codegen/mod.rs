@@ -236,6 +236,8 @@ pub struct Options {
     #[cfg(feature = "wasm_opt")]
     pub wasm_opt: Option<OptimizationPasses>,
     pub soroban_version: Option<u64>,
+    /// Heap size in bytes for Solana programs, 32 KiB if not set
+    pub solana_heap_size: Option<u32>,
 }
 
 impl Default for Options {
@@ -254,6 +256,7 @@ impl Default for Options {
             #[cfg(feature = "wasm_opt")]
             wasm_opt: None,
             soroban_version: None,
+            solana_heap_size: None,
         }
     }
 }
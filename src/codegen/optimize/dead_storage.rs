@@ -3,7 +3,7 @@
 use crate::codegen::cfg::{BasicBlock, ControlFlowGraph, Instr};
 use crate::codegen::Expression;
 use crate::sema::ast::{Namespace, RetrieveType, Type};
-use solang_parser::pt::Loc;
+use solang_parser::pt::{self, Loc};
 use std::collections::{HashMap, HashSet};
 use std::fmt;
 
@@ -259,6 +259,11 @@ fn instr_transfers(block_no: usize, block: &BasicBlock) -> Vec<Vec<Transfer>> {
                     Transfer::Store { def, expr: None },
                 ]
             }
+            Instr::ExternalCall { success: None, .. }
+            | Instr::ValueTransfer { success: None, .. } => {
+                // No success variable, but the callee can still call us back and modify storage
+                vec![Transfer::Store { def, expr: None }]
+            }
             Instr::Store { dest, .. } => {
                 let mut v = Vec::new();
 
@@ -495,7 +500,10 @@ pub fn dead_storage(cfg: &mut ControlFlowGraph, _ns: &mut Namespace) {
 
             match &cfg.blocks[block_no].instr[instr_no] {
                 Instr::LoadStorage {
-                    res, ty, storage, ..
+                    res,
+                    ty,
+                    storage,
+                    storage_type,
                 } => {
                     // is there a definition which has the same storage expression
                     let mut found = None;
@@ -537,6 +545,23 @@ pub fn dead_storage(cfg: &mut ControlFlowGraph, _ns: &mut Namespace) {
                                 var_no: *var_no,
                             },
                         };
+                    } else if let Some(value) = forwarded_store(
+                        block_no,
+                        instr_no,
+                        storage,
+                        ty,
+                        storage_type,
+                        vars,
+                        cfg,
+                        &blocktransfers,
+                        &block_vars,
+                    ) {
+                        // the store is no longer needed for this load, so it may become redundant
+                        cfg.blocks[block_no].instr[instr_no] = Instr::Set {
+                            loc: Loc::Codegen,
+                            res: *res,
+                            expr: value,
+                        };
                     } else {
                         for (def, expr) in &vars.stores {
                             let def_vars = get_vars_at(def, &block_vars);
@@ -609,6 +634,89 @@ pub fn dead_storage(cfg: &mut ControlFlowGraph, _ns: &mut Namespace) {
     }
 }
 
+/// If the storage slot of a load was set earlier in the same block, and nothing since then
+/// can have modified it, return the value which was stored so the load can be replaced.
+/// The reaching stores are merged from all predecessors at the start of a block, so a store
+/// from another block may not have been executed on every path to the load.
+#[allow(clippy::too_many_arguments)]
+fn forwarded_store(
+    block_no: usize,
+    instr_no: usize,
+    storage: &Expression,
+    ty: &Type,
+    storage_type: &Option<pt::StorageType>,
+    vars: &ReachingDefs,
+    cfg: &ControlFlowGraph,
+    block_transfers: &[Vec<Vec<Transfer>>],
+    block_vars: &BlockVars,
+) -> Option<Expression> {
+    let pos = vars.stores.iter().rposition(|(def, expr)| {
+        let def_vars = get_vars_at(def, block_vars);
+
+        expression_compare(storage, vars, expr, &def_vars, cfg, block_vars) == ExpressionCmp::Equal
+    })?;
+
+    // any later store which might be to the same slot could have overwritten the value
+    for (def, expr) in &vars.stores[pos + 1..] {
+        let def_vars = get_vars_at(def, block_vars);
+
+        if expression_compare(storage, vars, expr, &def_vars, cfg, block_vars)
+            != ExpressionCmp::NotEqual
+        {
+            return None;
+        }
+    }
+
+    let Definition::Instr {
+        block_no: store_block_no,
+        instr_no: store_instr_no,
+        ..
+    } = vars.stores[pos].0
+    else {
+        return None;
+    };
+
+    if store_block_no != block_no || store_instr_no >= instr_no {
+        return None;
+    }
+
+    let Instr::SetStorage {
+        ty: store_ty,
+        value,
+        storage_type: store_storage_type,
+        ..
+    } = &cfg.blocks[block_no].instr[store_instr_no]
+    else {
+        return None;
+    };
+
+    if store_ty != ty
+        || store_storage_type != storage_type
+        || !ty.is_primitive()
+        || value.ty() != *ty
+    {
+        return None;
+    }
+
+    match value {
+        Expression::NumberLiteral { .. } | Expression::BoolLiteral { .. } => Some(value.clone()),
+        Expression::Variable { var_no, .. } => {
+            // the variable must still hold the value that was stored
+            let assigned = block_transfers[block_no][store_instr_no + 1..instr_no]
+                .iter()
+                .flatten()
+                .any(|transfer| matches!(transfer, Transfer::Kill { var_no: no } if no == var_no));
+
+            if assigned {
+                None
+            } else {
+                Some(value.clone())
+            }
+        }
+        _ => None,
+    }
+}
+
 struct StorageDef<'a> {
     var_no: usize,
     slot: &'a Expression,
@@ -33,7 +33,8 @@ use inkwell::types::{
     ArrayType, BasicMetadataTypeEnum, BasicType, BasicTypeEnum, FunctionType, IntType, StringRadix,
 };
 use inkwell::values::{
-    BasicValue, BasicValueEnum, FunctionValue, GlobalValue, IntValue, PointerValue,
+    BasicMetadataValueEnum, BasicValue, BasicValueEnum, FunctionValue, GlobalValue, IntValue,
+    PointerValue,
 };
 use inkwell::AddressSpace;
 use inkwell::IntPredicate;
@@ -857,6 +858,26 @@ impl<'a> Binary<'a> {
         )
     }
 
+    /// Copy len bytes from src to dest in reverse order, to convert between big and little
+    /// endian. The stdlib has word at a time versions for the most common lengths.
+    pub(crate) fn reverse_bytes(&self, src: PointerValue<'a>, dest: PointerValue<'a>, len: u64) {
+        let (name, args): (String, Vec<BasicMetadataValueEnum>) = match len {
+            20 | 32 | 64 => (format!("__bswap_bytes{len}"), vec![src.into(), dest.into()]),
+            _ => (
+                "__beNtoleN".to_string(),
+                vec![
+                    src.into(),
+                    dest.into(),
+                    self.context.i32_type().const_int(len, false).into(),
+                ],
+            ),
+        };
+
+        self.builder
+            .build_call(self.module.get_function(&name).unwrap(), &args, "")
+            .unwrap();
+    }
+
     // Create the llvm intrinsic for bswap
     pub fn llvm_bswap(&self, bit: u32) -> FunctionValue<'a> {
         let name = format!("llvm.bswap.i{bit}");
@@ -5,7 +5,7 @@ use crate::codegen::error::CodegenError;
 use crate::codegen::revert::PanicCode;
 use crate::codegen::{Builtin, Expression};
 use crate::emit::binary::Binary;
-use crate::emit::math::{build_binary_op_with_overflow_check, multiply, power};
+use crate::emit::math::{build_binary_op_with_overflow_check, modular_arithmetic, multiply, power};
 use crate::emit::strings::{format_string, string_location};
 use crate::emit::{loop_builder::LoopBuilder, BinaryOp, TargetRuntime, Variable};
 use crate::emit_context;
@@ -15,7 +15,8 @@ use inkwell::builder::BuilderError;
 use inkwell::module::Linkage;
 use inkwell::types::{BasicType, StringRadix};
 use inkwell::values::{
-    ArrayValue, BasicValue, BasicValueEnum, FunctionValue, IntValue, PointerValue,
+    ArrayValue, BasicMetadataValueEnum, BasicValue, BasicValueEnum, FunctionValue, IntValue,
+    PointerValue,
 };
 use inkwell::{AddressSpace, IntPredicate};
 use num_bigint::Sign;
@@ -1557,8 +1558,8 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
         } => {
             let e = expression(target, bin, expr, vartab, function).into_int_value();
 
-            let size = e.get_type().get_bit_width() / 8;
-            let size = bin.context.i32_type().const_int(size as u64, false);
+            let len = e.get_type().get_bit_width() / 8;
+            let size = bin.context.i32_type().const_int(len as u64, false);
             let elem_size = bin.context.i32_type().const_int(1, false);
 
             // Swap the byte order
@@ -1567,15 +1568,7 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
                 panic!("{}", CodegenError::llvm_builder("emitting expression", err))
             });
             let init = bin.build_alloca(function, e.get_type(), "init");
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__leNtobeN", "converting bytes to big endian"),
-                    &[bytes_ptr.into(), init.into(), size.into()],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(bytes_ptr, init, len as u64);
 
             let allocator = if bin.ns.target == Target::Soroban {
                 bin.builder
@@ -1645,15 +1638,7 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
             let ty = bin.context.custom_width_int_type(*n as u32 * 8);
             let le_bytes_ptr = bin.build_alloca(function, ty, "le_bytes");
 
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__beNtoleN", "converting bytes to little endian"),
-                    &[bytes_ptr.into(), le_bytes_ptr.into(), len.into()],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(bytes_ptr, le_bytes_ptr, *n as u64);
             bin.builder
                 .build_load(ty, le_bytes_ptr, "bytes")
                 .unwrap_or_else(|err| {
@@ -2077,19 +2062,7 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
                 let bytes_ty = bin.context.custom_width_int_type(n as u32 * 8);
 
                 let store = bin.build_alloca(function, bytes_ty, "stack");
-                bin.builder
-                    .build_call(
-                        runtime_helper(bin, "__beNtoleN", "converting array literal bytes"),
-                        &[
-                            start.into(),
-                            store.into(),
-                            bin.context.i32_type().const_int(n as u64, false).into(),
-                        ],
-                        "",
-                    )
-                    .unwrap_or_else(|err| {
-                        panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                    });
+                bin.reverse_bytes(start, store, n as u64);
                 bin.builder
                     .build_load(bytes_ty, store, &format!("bytes{n}"))
                     .unwrap_or_else(|err| {
@@ -2235,19 +2208,7 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
             let selector = bin.build_alloca(function, selector_type, "selector");
 
             // byte order needs to be reversed. e.g. hex"11223344" should be 0x10 0x11 0x22 0x33 0x44
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__beNtoleN", "loading selector bytes"),
-                    &[
-                        bin.selector.as_pointer_value().into(),
-                        selector.into(),
-                        bin.context.i32_type().const_int(4, false).into(),
-                    ],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(bin.selector.as_pointer_value(), selector, 4);
 
             bin.builder
                 .build_load(selector_type, selector, "selector")
@@ -2256,236 +2217,15 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
                 })
         }
         Expression::Builtin {
-            kind: Builtin::AddMod,
-            args,
-            ..
-        } => {
-            let arith_ty = bin.context.custom_width_int_type(512);
-            let res_ty = bin.context.custom_width_int_type(256);
-
-            let x = expression(target, bin, &args[0], vartab, function).into_int_value();
-            let y = expression(target, bin, &args[1], vartab, function).into_int_value();
-            let k = expression(target, bin, &args[2], vartab, function).into_int_value();
-            let dividend = bin
-                .builder
-                .build_int_add(
-                    bin.builder
-                        .build_int_z_extend(x, arith_ty, "wide_x")
-                        .unwrap_or_else(|err| {
-                            panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                        }),
-                    bin.builder
-                        .build_int_z_extend(y, arith_ty, "wide_y")
-                        .unwrap_or_else(|err| {
-                            panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                        }),
-                    "x_plus_y",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            let divisor = bin
-                .builder
-                .build_int_z_extend(k, arith_ty, "wide_k")
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            let pdividend = bin.build_alloca(function, arith_ty, "dividend");
-            let pdivisor = bin.build_alloca(function, arith_ty, "divisor");
-            let rem = bin.build_alloca(function, arith_ty, "remainder");
-            let quotient = bin.build_alloca(function, arith_ty, "quotient");
-
-            bin.builder
-                .build_store(pdividend, dividend)
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-            bin.builder
-                .build_store(pdivisor, divisor)
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            let ret = bin
-                .builder
-                .build_call(
-                    runtime_helper(bin, "udivmod512", "addmod builtin lowering"),
-                    &[
-                        pdividend.into(),
-                        pdivisor.into(),
-                        rem.into(),
-                        quotient.into(),
-                    ],
-                    "quotient",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                })
-                .try_as_basic_value()
-                .left()
-                .unwrap_or_else(|| expect_return_value(None, "reading LLVM call return value"))
-                .into_int_value();
-
-            let success = bin
-                .builder
-                .build_int_compare(
-                    IntPredicate::EQ,
-                    ret,
-                    bin.context.i32_type().const_zero(),
-                    "success",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            let success_block = bin.context.append_basic_block(function, "success");
-            let bail_block = bin.context.append_basic_block(function, "bail");
-            emit_or_panic(
-                bin.builder
-                    .build_conditional_branch(success, success_block, bail_block),
-                "emitting zero-modulus guard for addmod builtin",
-            );
-
-            bin.builder.position_at_end(bail_block);
-
-            // On Solana the return type is 64 bit
-            let ret: BasicValueEnum = bin
-                .builder
-                .build_int_z_extend(
-                    ret,
-                    bin.return_values[&ReturnCode::Success].get_type(),
-                    "ret",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                })
-                .into();
-
-            bin.builder.build_return(Some(&ret)).unwrap_or_else(|err| {
-                panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-            });
-            bin.builder.position_at_end(success_block);
-
-            let remainder = bin
-                .builder
-                .build_load(arith_ty, rem, "remainder")
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                })
-                .into_int_value();
-
-            bin.builder
-                .build_int_truncate(remainder, res_ty, "quotient")
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                })
-                .into()
-        }
-        Expression::Builtin {
-            kind: Builtin::MulMod,
+            kind: kind @ (Builtin::AddMod | Builtin::MulMod),
             args,
             ..
         } => {
-            let arith_ty = bin.context.custom_width_int_type(512);
-            let res_ty = bin.context.custom_width_int_type(256);
-
             let x = expression(target, bin, &args[0], vartab, function).into_int_value();
             let y = expression(target, bin, &args[1], vartab, function).into_int_value();
-            let x_m = bin.build_alloca(function, arith_ty, "x_m");
-            let y_m = bin.build_alloca(function, arith_ty, "x_y");
-            let x_times_y_m = bin.build_alloca(function, arith_ty, "x_times_y_m");
-
-            bin.builder
-                .build_store(
-                    x_m,
-                    bin.builder
-                        .build_int_z_extend(x, arith_ty, "wide_x")
-                        .unwrap_or_else(|err| {
-                            panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                        }),
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-            bin.builder
-                .build_store(
-                    y_m,
-                    bin.builder
-                        .build_int_z_extend(y, arith_ty, "wide_y")
-                        .unwrap_or_else(|err| {
-                            panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                        }),
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__mul32", "mulmod builtin multiplication lowering"),
-                    &[
-                        x_m.into(),
-                        y_m.into(),
-                        x_times_y_m.into(),
-                        bin.context.i32_type().const_int(512 / 32, false).into(),
-                    ],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
             let k = expression(target, bin, &args[2], vartab, function).into_int_value();
-            let dividend = bin
-                .builder
-                .build_load(arith_ty, x_times_y_m, "x_t_y")
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            let divisor = bin
-                .builder
-                .build_int_z_extend(k, arith_ty, "wide_k")
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
 
-            let pdividend = bin.build_alloca(function, arith_ty, "dividend");
-            let pdivisor = bin.build_alloca(function, arith_ty, "divisor");
-            let rem = bin.build_alloca(function, arith_ty, "remainder");
-            let quotient = bin.build_alloca(function, arith_ty, "quotient");
-
-            bin.builder
-                .build_store(pdividend, dividend)
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-            bin.builder
-                .build_store(pdivisor, divisor)
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
-
-            let ret = bin
-                .builder
-                .build_call(
-                    runtime_helper(bin, "udivmod512", "mulmod builtin division lowering"),
-                    &[
-                        pdividend.into(),
-                        pdivisor.into(),
-                        rem.into(),
-                        quotient.into(),
-                    ],
-                    "quotient",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                })
-                .try_as_basic_value()
-                .left()
-                .unwrap_or_else(|| expect_return_value(None, "reading LLVM call return value"))
-                .into_int_value();
+            let (ret, rem) = modular_arithmetic(bin, *kind, x, y, k, function);
 
             let success = bin
                 .builder
@@ -2504,7 +2244,7 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
             emit_or_panic(
                 bin.builder
                     .build_conditional_branch(success, success_block, bail_block),
-                "emitting zero-modulus guard for mulmod builtin",
+                "emitting zero-modulus guard for addmod/mulmod builtin",
             );
 
             bin.builder.position_at_end(bail_block);
@@ -2528,20 +2268,11 @@ pub(super) fn expression<'a, T: TargetRuntime<'a> + ?Sized>(
 
             bin.builder.position_at_end(success_block);
 
-            let remainder = bin
-                .builder
-                .build_load(arith_ty, rem, "quotient")
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                })
-                .into_int_value();
-
             bin.builder
-                .build_int_truncate(remainder, res_ty, "quotient")
+                .build_load(x.get_type(), rem, "remainder")
                 .unwrap_or_else(|err| {
                     panic!("{}", CodegenError::llvm_builder("emitting expression", err))
                 })
-                .into()
         }
         Expression::Builtin {
             kind: hash @ Builtin::Ripemd160,
@@ -2766,6 +2497,13 @@ pub(super) fn compare_address<'a, T: TargetRuntime<'a> + ?Sized>(
     let left = bin.build_alloca(function, bin.address_type(), "left");
     let right = bin.build_alloca(function, bin.address_type(), "right");
 
+    // word align both sides so the fixed width comparison can go a word at a time
+    for ptr in [left, right] {
+        if let Some(alloca) = ptr.as_instruction() {
+            alloca.set_alignment(8).unwrap();
+        }
+    }
+
     bin.builder
         .build_store(left, l)
         .unwrap_or_else(|err| panic!("{}", CodegenError::llvm_builder("emitting expression", err)));
@@ -2773,11 +2511,11 @@ pub(super) fn compare_address<'a, T: TargetRuntime<'a> + ?Sized>(
         .build_store(right, r)
         .unwrap_or_else(|err| panic!("{}", CodegenError::llvm_builder("emitting expression", err)));
 
-    let res = bin
-        .builder
-        .build_call(
-            runtime_helper(bin, "__memcmp_ord", "comparing byte slices"),
-            &[
+    let (name, args): (&str, Vec<BasicMetadataValueEnum>) = match bin.ns.address_length {
+        32 => ("__memcmp_ord32", vec![left.into(), right.into()]),
+        _ => (
+            "__memcmp_ord",
+            vec![
                 left.into(),
                 right.into(),
                 bin.context
@@ -2785,6 +2523,14 @@ pub(super) fn compare_address<'a, T: TargetRuntime<'a> + ?Sized>(
                     .const_int(bin.ns.address_length as u64, false)
                     .into(),
             ],
+        ),
+    };
+
+    let res = bin
+        .builder
+        .build_call(
+            runtime_helper(bin, name, "comparing byte slices"),
+            &args,
             "",
         )
         .unwrap_or_else(|err| panic!("{}", CodegenError::llvm_builder("emitting expression", err)))
@@ -2861,20 +2607,7 @@ fn runtime_cast<'a>(
 
             let dest = bin.build_alloca(function, bin.address_type(), "address");
 
-            let len = bin
-                .context
-                .i32_type()
-                .const_int(bin.ns.address_length as u64, false);
-
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__leNtobeN", "converting fixed bytes to big endian"),
-                    &[src.into(), dest.into(), len.into()],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(src, dest, bin.ns.address_length as u64);
 
             bin.builder
                 .build_load(bin.address_type(), dest, "val")
@@ -2895,20 +2628,7 @@ fn runtime_cast<'a>(
 
             let dest = bin.build_alloca(function, llvm_ty, "dest");
 
-            let len = bin
-                .context
-                .i32_type()
-                .const_int(bin.ns.address_length as u64, false);
-
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__beNtoleN", "converting fixed bytes to little endian"),
-                    &[src.into(), dest.into(), len.into()],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(src, dest, bin.ns.address_length as u64);
 
             bin.builder
                 .build_load(llvm_ty, dest, "val")
@@ -3052,22 +2772,7 @@ fn runtime_cast<'a>(
                 "dest",
             );
 
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__leNtobeN", "converting address to bytes"),
-                    &[
-                        src.into(),
-                        dest.into(),
-                        bin.context
-                            .i32_type()
-                            .const_int((*bytes_length).into(), false)
-                            .into(),
-                    ],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(src, dest, (*bytes_length).into());
 
             let slice_ty = bin.llvm_type(to);
             let slice = bin.build_alloca(function, slice_ty, "slice");
@@ -3280,15 +2985,7 @@ fn basic_value_to_slice<'a>(
                 .unwrap_or_else(|| expect_return_value(None, "reading LLVM call return value"))
                 .into_pointer_value();
 
-            bin.builder
-                .build_call(
-                    runtime_helper(bin, "__leNtobeN", "converting array bytes"),
-                    &[src.into(), dest.into(), i32_const!(bytes_length).into()],
-                    "",
-                )
-                .unwrap_or_else(|err| {
-                    panic!("{}", CodegenError::llvm_builder("emitting expression", err))
-                });
+            bin.reverse_bytes(src, dest, bytes_length);
 
             let len = i64_const!(bytes_length);
 
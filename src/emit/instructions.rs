@@ -227,27 +227,127 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
                 .size_of()
                 .unwrap()
                 .const_cast(bin.context.i32_type(), false);
-            let size = bin.builder.build_int_mul(elem_size, new_len, "").unwrap();
-            let size = bin.builder.build_int_add(size, vec_size, "").unwrap();
+            let new = if bin.ns.target == Target::Soroban {
+                // soroban_alloc_init() counts size in bytes rather than elements, so it cannot be
+                // used as the capacity. The allocator resizes in place at the cursor anyway.
+                let size = bin.builder.build_int_mul(elem_size, new_len, "").unwrap();
+                let size = bin.builder.build_int_add(size, vec_size, "").unwrap();
 
-            let allocator = if bin.ns.target == Target::Soroban {
-                "soroban_realloc"
+                // Reallocate and reassign the array pointer
+                bin.builder
+                    .build_call(
+                        bin.module.get_function("soroban_realloc").unwrap(),
+                        &[arr.into(), size.into()],
+                        "",
+                    )
+                    .unwrap()
+                    .try_as_basic_value()
+                    .left()
+                    .unwrap()
+                    .into_pointer_value()
             } else {
-                "__realloc"
+                // The size field is the capacity of the vector. Only reallocate once it is
+                // exhausted, and then double it so that pushing n elements is O(n).
+                let arr = arr.into_pointer_value();
+                let size_ptr = unsafe {
+                    bin.builder
+                        .build_gep(
+                            llvm_ty,
+                            arr,
+                            &[
+                                bin.context.i32_type().const_zero(),
+                                bin.context.i32_type().const_int(1, false),
+                            ],
+                            "size",
+                        )
+                        .unwrap()
+                };
+                let capacity = bin
+                    .builder
+                    .build_select(
+                        bin.builder.build_is_null(arr, "vector_is_null").unwrap(),
+                        bin.context.i32_type().const_zero(),
+                        bin.builder
+                            .build_load(bin.context.i32_type(), size_ptr, "capacity")
+                            .unwrap()
+                            .into_int_value(),
+                        "capacity",
+                    )
+                    .unwrap()
+                    .into_int_value();
+
+                let is_full = bin
+                    .builder
+                    .build_int_compare(IntPredicate::UGT, new_len, capacity, "is_full")
+                    .unwrap();
+
+                let entry = bin.builder.get_insert_block().unwrap();
+                let grow = bin.context.append_basic_block(function, "grow");
+                let push = bin.context.append_basic_block(function, "push");
+                bin.builder
+                    .build_conditional_branch(is_full, grow, push)
+                    .unwrap();
+
+                bin.builder.position_at_end(grow);
+                let doubled = bin
+                    .builder
+                    .build_int_mul(capacity, bin.context.i32_type().const_int(2, false), "")
+                    .unwrap();
+                let new_capacity = bin
+                    .builder
+                    .build_select(
+                        bin.builder
+                            .build_int_compare(IntPredicate::UGT, doubled, new_len, "")
+                            .unwrap(),
+                        doubled,
+                        new_len,
+                        "new_capacity",
+                    )
+                    .unwrap()
+                    .into_int_value();
+                let size = bin
+                    .builder
+                    .build_int_mul(elem_size, new_capacity, "")
+                    .unwrap();
+                let size = bin.builder.build_int_add(size, vec_size, "").unwrap();
+
+                let grown = bin
+                    .builder
+                    .build_call(
+                        bin.module.get_function("__realloc").unwrap(),
+                        &[arr.into(), size.into()],
+                        "",
+                    )
+                    .unwrap()
+                    .try_as_basic_value()
+                    .left()
+                    .unwrap()
+                    .into_pointer_value();
+
+                let size_ptr = unsafe {
+                    bin.builder
+                        .build_gep(
+                            llvm_ty,
+                            grown,
+                            &[
+                                bin.context.i32_type().const_zero(),
+                                bin.context.i32_type().const_int(1, false),
+                            ],
+                            "size",
+                        )
+                        .unwrap()
+                };
+                bin.builder.build_store(size_ptr, new_capacity).unwrap();
+                bin.builder.build_unconditional_branch(push).unwrap();
+
+                bin.builder.position_at_end(push);
+                let new = bin
+                    .builder
+                    .build_phi(bin.context.ptr_type(AddressSpace::default()), "vector")
+                    .unwrap();
+                new.add_incoming(&[(&arr, entry), (&grown, grow)]);
+                new.as_basic_value().into_pointer_value()
             };
-            // Reallocate and reassign the array pointer
-            let new = bin
-                .builder
-                .build_call(
-                    bin.module.get_function(allocator).unwrap(),
-                    &[arr.into(), size.into()],
-                    "",
-                )
-                .unwrap()
-                .try_as_basic_value()
-                .left()
-                .unwrap()
-                .into_pointer_value();
             w.vars.get_mut(array).unwrap().value = new.into();
 
             // Store the value into the last element
@@ -278,7 +378,7 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
             };
             bin.builder.build_store(slot_ptr, value).unwrap();
 
-            // Update the len and size field of the vector struct
+            // Update the len field of the vector struct, and the size too on Soroban
             let len_ptr = unsafe {
                 bin.builder
                     .build_gep(
@@ -294,20 +394,22 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
             };
             bin.builder.build_store(len_ptr, new_len).unwrap();
 
-            let size_ptr = unsafe {
-                bin.builder
-                    .build_gep(
-                        llvm_ty,
-                        new,
-                        &[
-                            bin.context.i32_type().const_zero(),
-                            bin.context.i32_type().const_int(1, false),
-                        ],
-                        "size",
-                    )
-                    .unwrap()
-            };
-            bin.builder.build_store(size_ptr, new_len).unwrap();
+            if bin.ns.target == Target::Soroban {
+                let size_ptr = unsafe {
+                    bin.builder
+                        .build_gep(
+                            llvm_ty,
+                            new,
+                            &[
+                                bin.context.i32_type().const_zero(),
+                                bin.context.i32_type().const_int(1, false),
+                            ],
+                            "size",
+                        )
+                        .unwrap()
+                };
+                bin.builder.build_store(size_ptr, new_len).unwrap();
+            }
         }
         Instr::PopMemory {
             res,
@@ -378,8 +480,6 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
                 .size_of()
                 .unwrap()
                 .const_cast(bin.context.i32_type(), false);
-            let size = bin.builder.build_int_mul(elem_size, new_len, "").unwrap();
-            let size = bin.builder.build_int_add(size, vec_size, "").unwrap();
 
             // Get the pointer to the last element and return it
             let slot_ptr = unsafe {
@@ -406,27 +506,48 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
                 w.vars.get_mut(res).unwrap().value = ret_val;
             }
 
-            let allocator = if bin.ns.target == Target::Soroban {
-                "soroban_realloc"
+            // The size field is the capacity, which a pop leaves as it is. On Soroban it is kept
+            // equal to len, see PushMemory.
+            let new = if bin.ns.target == Target::Soroban {
+                let size = bin.builder.build_int_mul(elem_size, new_len, "").unwrap();
+                let size = bin.builder.build_int_add(size, vec_size, "").unwrap();
+
+                // Reallocate and reassign the array pointer
+                let new = bin
+                    .builder
+                    .build_call(
+                        bin.module.get_function("soroban_realloc").unwrap(),
+                        &[a.into(), size.into()],
+                        "",
+                    )
+                    .unwrap()
+                    .try_as_basic_value()
+                    .left()
+                    .unwrap()
+                    .into_pointer_value();
+                w.vars.get_mut(array).unwrap().value = new.into();
+
+                let size_ptr = unsafe {
+                    bin.builder
+                        .build_gep(
+                            llvm_ty,
+                            new,
+                            &[
+                                bin.context.i32_type().const_zero(),
+                                bin.context.i32_type().const_int(1, false),
+                            ],
+                            "size",
+                        )
+                        .unwrap()
+                };
+                bin.builder.build_store(size_ptr, new_len).unwrap();
+
+                new
             } else {
-                "__realloc"
+                a
             };
-            // Reallocate and reassign the array pointer
-            let new = bin
-                .builder
-                .build_call(
-                    bin.module.get_function(allocator).unwrap(),
-                    &[a.into(), size.into()],
-                    "",
-                )
-                .unwrap()
-                .try_as_basic_value()
-                .left()
-                .unwrap()
-                .into_pointer_value();
-            w.vars.get_mut(array).unwrap().value = new.into();
 
-            // Update the len and size field of the vector struct
+            // Update the len field of the vector struct
             let len_ptr = unsafe {
                 bin.builder
                     .build_gep(
@@ -441,21 +562,6 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
                     .unwrap()
             };
             bin.builder.build_store(len_ptr, new_len).unwrap();
-
-            let size_ptr = unsafe {
-                bin.builder
-                    .build_gep(
-                        llvm_ty,
-                        new,
-                        &[
-                            bin.context.i32_type().const_zero(),
-                            bin.context.i32_type().const_int(1, false),
-                        ],
-                        "size",
-                    )
-                    .unwrap()
-            };
-            bin.builder.build_store(size_ptr, new_len).unwrap();
         }
         Instr::AssertFailure { encoded_args: None } => {
             target.assert_failure(
@@ -1086,20 +1192,7 @@ pub(super) fn process_instruction<'a, T: TargetRuntime<'a> + ?Sized>(
                     bin.builder
                         .build_store(value_ptr, emit_value.into_int_value())
                         .unwrap();
-                    bin.builder
-                        .build_call(
-                            bin.module.get_function("__leNtobeN").unwrap(),
-                            &[
-                                value_ptr.into(),
-                                start.into(),
-                                bin.context
-                                    .i32_type()
-                                    .const_int(is_bytes as u64, false)
-                                    .into(),
-                            ],
-                            "",
-                        )
-                        .unwrap();
+                    bin.reverse_bytes(value_ptr, start, is_bytes as u64);
                 } else {
                     bin.builder.build_store(start, emit_value).unwrap();
                 }
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 use crate::codegen::revert::PanicCode;
+use crate::codegen::Builtin;
 use crate::emit::binary::Binary;
 use crate::emit::{BinaryOp, TargetRuntime};
 use inkwell::types::IntType;
@@ -247,7 +248,8 @@ fn signed_ovf_detect<'a, T: TargetRuntime<'a> + ?Sized>(
         .unwrap()
 }
 
-/// Call void __mul32 and return the result.
+/// Call void __mul32 and return the result. For 256 and 512 bits, the fixed width
+/// versions __mul32_256 and __mul32_512 are used.
 fn call_mul32_without_ovf<'a>(
     bin: &Binary<'a>,
     l: PointerValue<'a>,
@@ -257,21 +259,33 @@ fn call_mul32_without_ovf<'a>(
     mul_type: IntType<'a>,
     res_type: IntType<'a>,
 ) -> IntValue<'a> {
-    bin.builder
-        .build_call(
-            bin.module.get_function("__mul32").unwrap(),
-            &[
-                l.into(),
-                r.into(),
-                o.into(),
-                bin.context
-                    .i32_type()
-                    .const_int(mul_bits as u64 / 32, false)
-                    .into(),
-            ],
-            "",
-        )
-        .unwrap();
+    if mul_bits == 256 || mul_bits == 512 {
+        bin.builder
+            .build_call(
+                bin.module
+                    .get_function(&format!("__mul32_{mul_bits}"))
+                    .unwrap(),
+                &[l.into(), r.into(), o.into()],
+                "",
+            )
+            .unwrap();
+    } else {
+        bin.builder
+            .build_call(
+                bin.module.get_function("__mul32").unwrap(),
+                &[
+                    l.into(),
+                    r.into(),
+                    o.into(),
+                    bin.context
+                        .i32_type()
+                        .const_int(mul_bits as u64 / 32, false)
+                        .into(),
+                ],
+                "",
+            )
+            .unwrap();
+    }
 
     let res = bin.builder.build_load(mul_type, o, "mul").unwrap();
 
@@ -297,6 +311,50 @@ fn extract_sign_bit<'a>(
         .unwrap()
 }
 
+/// Emit a call to __addmod256 or __mulmod256 for the addmod and mulmod builtins. The
+/// stdlib keeps the intermediate at full width and reduces it with a single division.
+/// Returns the status of the call, which is non-zero if the modulus is zero, and a
+/// pointer to the result.
+pub(super) fn modular_arithmetic<'a>(
+    bin: &Binary<'a>,
+    kind: Builtin,
+    x: IntValue<'a>,
+    y: IntValue<'a>,
+    k: IntValue<'a>,
+    function: FunctionValue<'a>,
+) -> (IntValue<'a>, PointerValue<'a>) {
+    let name = match kind {
+        Builtin::AddMod => "__addmod256",
+        Builtin::MulMod => "__mulmod256",
+        _ => unreachable!(),
+    };
+
+    let ty = x.get_type();
+    let x_m = bin.build_alloca(function, ty, "x");
+    let y_m = bin.build_alloca(function, ty, "y");
+    let k_m = bin.build_alloca(function, ty, "k");
+    let rem = bin.build_alloca(function, ty, "remainder");
+
+    bin.builder.build_store(x_m, x).unwrap();
+    bin.builder.build_store(y_m, y).unwrap();
+    bin.builder.build_store(k_m, k).unwrap();
+
+    let ret = bin
+        .builder
+        .build_call(
+            bin.module.get_function(name).unwrap(),
+            &[x_m.into(), y_m.into(), k_m.into(), rem.into()],
+            "ret",
+        )
+        .unwrap()
+        .try_as_basic_value()
+        .left()
+        .unwrap()
+        .into_int_value();
+
+    (ret, rem)
+}
+
 /// Emit a multiply for any width with or without overflow checking
 pub(super) fn multiply<'a, T: TargetRuntime<'a> + ?Sized>(
     target: &T,
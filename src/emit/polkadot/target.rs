@@ -1101,10 +1101,7 @@ impl<'a> TargetRuntime<'a> for PolkadotTarget {
             .build_alloca(bin.llvm_type(&ast::Type::Bytes(hashlen as u8)), "hash")
             .unwrap();
 
-        call!(
-            "__beNtoleN",
-            &[res.into(), temp.into(), i32_const!(hashlen).into()]
-        );
+        bin.reverse_bytes(res, temp, hashlen);
 
         bin.builder
             .build_load(
@@ -43,6 +43,16 @@ impl SolanaTarget {
             None,
         );
 
+        // the stdlib heap takes its size from this constant
+        let heap_size = bin.module.get_global("solang_heap_size").unwrap();
+        heap_size.set_initializer(
+            &context
+                .i32_type()
+                .const_int(opt.solana_heap_size.unwrap_or(32 * 1024).into(), false),
+        );
+        heap_size.set_constant(true);
+        heap_size.set_linkage(Linkage::Internal);
+
         bin.return_values
             .insert(ReturnCode::Success, context.i64_type().const_zero());
         bin.return_values.insert(
@@ -321,7 +331,7 @@ impl SolanaTarget {
             bin.builder
                 .build_call(
                     bin.module.get_function("account_data_free").unwrap(),
-                    &[data.into(), offset.into()],
+                    &[self.contract_storage_account(bin).into(), offset.into()],
                     "",
                 )
                 .unwrap();
@@ -390,7 +400,7 @@ impl SolanaTarget {
                 bin.builder
                     .build_call(
                         bin.module.get_function("account_data_free").unwrap(),
-                        &[data.into(), offset.into()],
+                        &[self.contract_storage_account(bin).into(), offset.into()],
                         "",
                     )
                     .unwrap();
@@ -883,7 +883,7 @@ impl<'a> TargetRuntime<'a> for SolanaTarget {
                 bin.builder
                     .build_call(
                         bin.module.get_function("account_data_free").unwrap(),
-                        &[data.into(), offset.into()],
+                        &[account.into(), offset.into()],
                         "free",
                     )
                     .unwrap();
@@ -2005,17 +2005,7 @@ impl<'a> TargetRuntime<'a> for SolanaTarget {
             "hash",
         );
 
-        bin.builder
-            .build_call(
-                bin.module.get_function("__beNtoleN").unwrap(),
-                &[
-                    res.into(),
-                    temp.into(),
-                    bin.context.i32_type().const_int(hashlen, false).into(),
-                ],
-                "",
-            )
-            .unwrap();
+        bin.reverse_bytes(res, temp, hashlen);
 
         bin.builder
             .build_load(
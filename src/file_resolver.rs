@@ -11,7 +11,7 @@ use std::io::prelude::*;
 use std::path::{Path, PathBuf};
 use std::sync::Arc;
 
-#[derive(Default)]
+#[derive(Clone, Default)]
 pub struct FileResolver {
     /// Set of import paths search for imports
     import_paths: Vec<(Option<OsString>, PathBuf)>,
@@ -19,6 +19,8 @@ pub struct FileResolver {
     cached_paths: HashMap<PathBuf, usize>,
     /// The actual file contents
     files: Vec<ResolvedFile>,
+    /// Paths which were looked up while resolving, but where no file was found
+    missing_paths: Vec<PathBuf>,
 }
 
 /// When we resolve a file, we need to know its base compared to the import so
@@ -95,6 +97,12 @@ impl FileResolver {
         self.files.get(file_no).map(|f| f.contents.clone())
     }
 
+    /// Get the paths which were looked up while resolving, but where no file was found. If
+    /// any of these exist later, resolving the same imports may find different files.
+    pub fn get_missing_paths(&self) -> &[PathBuf] {
+        self.missing_paths.as_slice()
+    }
+
     /// Get file with contents. This must be a file which was previously
     /// add to the cache
     pub fn get_file_contents_and_number(&self, file: &Path) -> (Arc<str>, usize) {
@@ -127,6 +135,8 @@ impl FileResolver {
             return Ok(Some(file.clone()));
         }
 
+        self.missing_paths.push(cache_path);
+
         Ok(None)
     }
 
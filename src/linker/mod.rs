@@ -6,16 +6,18 @@ mod soroban_wasm;
 use crate::Target;
 use once_cell::sync::Lazy;
 use std::ffi::CString;
+use std::fs::File;
+use std::io::Write;
+use std::path::{Path, PathBuf};
 use std::sync::Mutex;
 
+/// The lld linker is totally not thread-safe; it keeps its state in globals rather than in
+/// a per-link context. Only the call into lld itself is serialised, so that writing the inputs,
+/// reading the output and any post-processing of the linked module can run concurrently.
 static LINKER_MUTEX: Lazy<Mutex<i32>> = Lazy::new(|| Mutex::new(0i32));
 
 /// Take an object file and turn it into a final linked binary ready for deployment
 pub fn link(input: &[u8], name: &str, target: Target) -> Vec<u8> {
-    // The lld linker is totally not thread-safe; it uses many globals
-    // We should fix this one day
-    let _lock = LINKER_MUTEX.lock().unwrap();
-
     match target {
         Target::Solana => bpf::link(input, name),
         Target::Soroban => soroban_wasm::link(input, name),
@@ -42,6 +44,8 @@ pub fn elf_linker(args: &[CString]) -> bool {
         command_line.push(arg.as_ptr());
     }
 
+    let _lock = LINKER_MUTEX.lock().unwrap();
+
     unsafe { LLDELFLink(command_line.as_ptr(), command_line.len()) == 0 }
 }
 
@@ -60,5 +64,61 @@ pub fn wasm_linker(args: &[CString]) -> bool {
         command_line.push(arg.as_ptr());
     }
 
+    let _lock = LINKER_MUTEX.lock().unwrap();
+
     unsafe { LLDWasmLink(command_line.as_ptr(), command_line.len()) == 0 }
 }
+
+/// An input file for lld. lld only reads its inputs by path, so on Linux the contents are put
+/// in an anonymous memfd which lld opens through `/proc/self/fd`; this never touches the disk.
+/// Elsewhere the contents are written to `dir`. The file must be kept alive until lld has run.
+pub struct InputFile {
+    _file: File,
+    path: PathBuf,
+}
+
+impl InputFile {
+    pub fn new(dir: &Path, name: &str, contents: &[u8]) -> Self {
+        let (mut file, path) = Self::create(dir, name);
+
+        file.write_all(contents)
+            .expect("failed to write linker input file");
+
+        InputFile { _file: file, path }
+    }
+
+    #[cfg(target_os = "linux")]
+    fn create(dir: &Path, name: &str) -> (File, PathBuf) {
+        use std::os::fd::FromRawFd;
+
+        let c_name = CString::new(name).unwrap();
+
+        let fd = unsafe { libc::memfd_create(c_name.as_ptr(), libc::MFD_CLOEXEC) };
+
+        if fd >= 0 {
+            let file = unsafe { File::from_raw_fd(fd) };
+
+            (file, PathBuf::from(format!("/proc/self/fd/{fd}")))
+        } else {
+            // memfd_create is not available, e.g. in some sandboxes
+            Self::create_in_dir(dir, name)
+        }
+    }
+
+    #[cfg(not(target_os = "linux"))]
+    fn create(dir: &Path, name: &str) -> (File, PathBuf) {
+        Self::create_in_dir(dir, name)
+    }
+
+    fn create_in_dir(dir: &Path, name: &str) -> (File, PathBuf) {
+        let path = dir.join(name);
+
+        let file = File::create(&path).expect("failed to create linker input file");
+
+        (file, path)
+    }
+
+    pub fn arg(&self) -> CString {
+        CString::new(self.path.to_str().expect("temp path should be unicode")).unwrap()
+    }
+}
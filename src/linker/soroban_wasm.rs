@@ -1,9 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
+use super::InputFile;
 use std::ffi::CString;
-use std::fs::File;
-use std::io::Read;
-use std::io::Write;
 use tempfile::tempdir;
 use wasm_encoder::{
     ConstExpr, EntityType, GlobalSection, GlobalType, ImportSection, MemoryType, Module,
@@ -14,15 +12,9 @@ use wasmparser::{Global, Import, Parser, Payload::*, SectionLimited, TypeRef};
 pub fn link(input: &[u8], name: &str) -> Vec<u8> {
     let dir = tempdir().expect("failed to create temp directory for linking");
 
-    let object_filename = dir.path().join(format!("{name}.o"));
     let res_filename = dir.path().join(format!("{name}.wasm"));
 
-    let mut objectfile =
-        File::create(object_filename.clone()).expect("failed to create object file");
-
-    objectfile
-        .write_all(input)
-        .expect("failed to write object file to temp file");
+    let object_file = InputFile::new(dir.path(), &format!("{name}.o"), input);
 
     // Assemble wasm-ld command line
     let mut command_line = vec![
@@ -34,27 +26,14 @@ pub fn link(input: &[u8], name: &str) -> Vec<u8> {
     ];
     command_line.push(CString::new("--export-dynamic").unwrap());
 
-    command_line.push(
-        CString::new(
-            object_filename
-                .to_str()
-                .expect("temp path should be unicode"),
-        )
-        .unwrap(),
-    );
+    command_line.push(object_file.arg());
     command_line.push(CString::new("-o").unwrap());
     command_line
         .push(CString::new(res_filename.to_str().expect("temp path should be unicode")).unwrap());
 
     assert!(!super::wasm_linker(&command_line), "linker failed");
 
-    let mut output = Vec::new();
-    // read the whole file
-    let mut outputfile = File::open(res_filename).expect("output file should exist");
-
-    outputfile
-        .read_to_end(&mut output)
-        .expect("failed to read output file");
+    let output = std::fs::read(res_filename).expect("failed to read output file");
 
     //output
     generate_module(&output)
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Native benchmark of the stdlib runtime. This times each primitive on the host, so it is only
+// useful for comparing two versions of the stdlib against each other.
+//
+// make bench && ./bench
+//
+// The compute units used on Solana are printed by the tests in tests/solana.rs for each call when
+// SOLANG_COMPUTE_UNITS is set, e.g. SOLANG_COMPUTE_UNITS=1 cargo test -- --nocapture
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stdlib.h"
+#include "solana_sdk.h"
+
+typedef unsigned _BitInt(256) uint256_t;
+
+extern void __init_heap();
+extern void __free(void *m);
+extern void __mul32(uint32_t left[], uint32_t right[], uint32_t out[], int len);
+extern int udivmod256(uint256_t *pdividend, uint256_t *pdivisor, uint256_t *remainder, uint256_t *quotient);
+extern char *uint256dec(char *output, uint256_t *val256);
+extern void base58_encode_solana_address(uint8_t *data, uint32_t data_len, uint8_t *output, uint32_t output_len);
+extern void ripemd160(void *in, int inlen, void *out);
+extern int __memcmp_ord(uint8_t *a, uint8_t *b, uint32_t len);
+extern int __memcmp_ord32(uint8_t *a, uint8_t *b);
+extern uint64_t account_data_alloc(SolAccountInfo *ai, uint32_t size, uint32_t *res);
+extern void account_data_free(SolAccountInfo *ai, uint32_t offset);
+
+#define ITERATIONS 1000000
+
+static uint64_t now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t start)
+{
+    printf("%-32s %8.1f ns/op\n", name, (double)(now() - start) / ITERATIONS);
+}
+
+#define MEASURE(name, body)                                                                                            \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        uint64_t start = now();                                                                                        \
+        for (int i = 0; i < ITERATIONS; i++)                                                                           \
+        {                                                                                                              \
+            body;                                                                                                      \
+        }                                                                                                              \
+        report(name, start);                                                                                           \
+    } while (0)
+
+static uint8_t data[0x10000];
+static SolAccountInfo ai = {.data = data, .data_len = sizeof(data)};
+
+static void account_data_alloc_free(uint32_t size)
+{
+    uint32_t offset;
+
+    account_data_alloc(&ai, size, &offset);
+    account_data_free(&ai, offset);
+}
+
+int main()
+{
+    uint8_t buf[256], buf2[256];
+    uint32_t left[8], right[8], out[8];
+    uint256_t a, b, rem, quot;
+    char str[100];
+
+    for (int i = 0; i < sizeof(buf); i++)
+        buf[i] = i * 7 + 1;
+
+    for (int i = 0; i < 8; i++)
+    {
+        left[i] = 0x9e3779b9u * (i + 1);
+        right[i] = 0x7f4a7c15u * (i + 1);
+    }
+
+    memcpy(&a, left, sizeof(a));
+    memcpy(&b, right, sizeof(b));
+    b >>= 100;
+
+    __init_heap();
+
+    MEASURE("__malloc/__free 32", __free(__malloc(32)));
+    MEASURE("__malloc/__free 200", __free(__malloc(200)));
+
+    // the magic and heap_offset fields of the account data header
+    ((uint32_t *)data)[0] = 0x41424344;
+    ((uint32_t *)data)[3] = 0x20;
+
+    uint32_t offsets[16];
+
+    // some live allocations so the free list is not trivially empty
+    for (int i = 0; i < 16; i++)
+        account_data_alloc(&ai, 40 + i * 8, &offsets[i]);
+    for (int i = 0; i < 16; i += 2)
+        account_data_free(&ai, offsets[i]);
+
+    MEASURE("account_data_alloc/free 100", account_data_alloc_free(100));
+
+    MEASURE("__mul32 256", __mul32(left, right, out, 8));
+    MEASURE("udivmod256", udivmod256(&a, &b, &rem, &quot));
+    MEASURE("uint256dec", uint256dec(str, &a));
+    MEASURE("base58_encode_solana_address", base58_encode_solana_address(buf, 32, (uint8_t *)str, 44));
+    MEASURE("ripemd160 64", ripemd160(buf, 64, str));
+    MEASURE("ripemd160 256", ripemd160(buf, 256, str));
+    MEASURE("__memcpy 256", __memcpy(buf2, buf, 256));
+    // buf2 is now equal to buf, so every byte is compared
+    MEASURE("__memcmp_ord 256", __memcmp_ord(buf, buf2, 256));
+    MEASURE("__memcmp_ord32", __memcmp_ord32(buf, buf2));
+    MEASURE("__memset 256", __memset(buf2, 0, 256));
+
+    return 0;
+}
+
+void sol_panic_(const char *s, uint64_t len, uint64_t line, uint64_t column)
+{
+    printf("panic: %s line %lld\n", s, line);
+}
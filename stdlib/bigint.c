@@ -20,38 +20,22 @@
     r5*l4	r4*l4	r3*l4	r2*l4 	r1*l4	0		0 		0  +
     ------------------------------------------------------------
 */
-void __mul32(uint32_t left[], uint32_t right[], uint32_t out[], int len)
+
+// Calculate the first len limbs of left * right, one column (output limb) at a time. Limbs at
+// or beyond left_len and right_len are known to be zero and are skipped. Returns the carry out
+// of the last column.
+static uint64_t mul32_columns(uint32_t left[], int left_len, uint32_t right[], int right_len, uint32_t out[], int len)
 {
     uint64_t val1 = 0, carry = 0;
 
-    int left_len = len, right_len = len;
-
-    while (left_len > 0 && !left[left_len - 1])
-        left_len--;
-
-    while (right_len > 0 && !right[right_len - 1])
-        right_len--;
-
-    int right_start = 0, right_end = 0;
-    int left_start = 0;
-
     for (int l = 0; l < len; l++)
     {
-        int i = 0;
-
-        if (l >= left_len)
-            right_start++;
+        int i = l < right_len ? 0 : l - right_len + 1;
+        int end = l < left_len ? l : left_len - 1;
 
-        if (l >= right_len)
-            left_start++;
-
-        if (right_end < right_len)
-            right_end++;
-
-        for (int r = right_end - 1; r >= right_start; r--)
+        for (; i <= end; i++)
         {
-            uint64_t m = (uint64_t)left[left_start + i] * (uint64_t)right[r];
-            i++;
+            uint64_t m = (uint64_t)left[i] * (uint64_t)right[l - i];
             if (__builtin_add_overflow(val1, m, &val1))
                 carry += 0x100000000;
         }
@@ -61,60 +45,78 @@ void __mul32(uint32_t left[], uint32_t right[], uint32_t out[], int len)
         val1 = (val1 >> 32) | carry;
         carry = 0;
     }
+
+    return val1;
+}
+
+void __mul32(uint32_t left[], uint32_t right[], uint32_t out[], int len)
+{
+    int left_len = len, right_len = len;
+
+    while (left_len > 0 && !left[left_len - 1])
+        left_len--;
+
+    while (right_len > 0 && !right[right_len - 1])
+        right_len--;
+
+    mul32_columns(left, left_len, right, right_len, out, len);
 }
 
 // A version of __mul32 that detects overflow.
 bool __mul32_with_builtin_ovf(uint32_t left[], uint32_t right[], uint32_t out[], int len)
 {
-    bool overflow = false;
-    uint64_t val1 = 0, carry = 0;
     int left_len = len, right_len = len;
+
     while (left_len > 0 && !left[left_len - 1])
         left_len--;
+
     while (right_len > 0 && !right[right_len - 1])
         right_len--;
-    int right_start = 0, right_end = 0;
-    int left_start = 0;
-    // We extend len to check for possible overflow. len = bit_width / 32. Checking for overflow for intN (where N = number of bits) requires checking for any set bits beyond N up to N*2.
-    len = len * 2;
-    for (int l = 0; l < len; l++)
-    {
-        int i = 0;
-        if (l >= left_len)
-            right_start++;
-        if (l >= right_len)
-            left_start++;
-        if (right_end < right_len)
-            right_end++;
 
-        for (int r = right_end - 1; r >= right_start; r--)
+    // The product of numbers with a and b significant limbs has a + b - 1 or a + b limbs. So if
+    // a + b - 1 > len, the product certainly overflows. Otherwise no product lands beyond the
+    // first len limbs, and there is an overflow if there is a carry out of the top limb.
+    if (left_len && right_len && left_len + right_len - 1 > len)
+        return true;
+
+    return mul32_columns(left, left_len, right, right_len, out, len) != 0;
+}
+
+/*
+    Fixed width versions of __mul32 for 256 and 512 bits. These are fully unrolled and do
+    not look for leading zero limbs.
+*/
+static inline __attribute__((always_inline)) void mul32_fixed(uint32_t left[], uint32_t right[], uint32_t out[],
+                                                                 const int len)
+{
+    uint64_t val1 = 0, carry = 0;
+
+#pragma clang loop unroll(full)
+    for (int k = 0; k < len; k++)
+    {
+#pragma clang loop unroll(full)
+        for (int i = 0; i <= k; i++)
         {
-            uint64_t m = (uint64_t)left[left_start + i] * (uint64_t)right[r];
-            i++;
+            uint64_t m = (uint64_t)left[i] * (uint64_t)right[k - i];
             if (__builtin_add_overflow(val1, m, &val1))
                 carry += 0x100000000;
         }
 
-        // If the loop is within the operand bit size, just do the assignment
-        if (l < len / 2)
-        {
-            out[l] = val1;
-        }
-
-        // If the loop extends to more than the bit size, we check for overflow.
-        else if (l >= len / 2)
-        {
-            if (val1 > 0)
-            {
-                overflow = true;
-                break;
-            }
-        }
+        out[k] = val1;
 
         val1 = (val1 >> 32) | carry;
         carry = 0;
     }
-    return overflow;
+}
+
+void __mul32_256(uint32_t left[8], uint32_t right[8], uint32_t out[8])
+{
+    mul32_fixed(left, right, out, 8);
+}
+
+void __mul32_512(uint32_t left[16], uint32_t right[16], uint32_t out[16])
+{
+    mul32_fixed(left, right, out, 16);
 }
 
 // Some compiler runtime builtins we need.
@@ -336,60 +338,182 @@ __uint128_t shr128(__uint128_t val, int r)
     }
 }
 
-int udivmod128(__uint128_t *pdividend, __uint128_t *pdivisor, __uint128_t *remainder, __uint128_t *quotient)
+/*
+    Knuth's Algorithm D (The Art of Computer Programming, Vol. 2, 4.3.1) over 32 bit limbs, which
+    is the widest multiply BPF and wasm can do natively. The dividend has m limbs and the divisor
+    n limbs, both with a non-zero top limb and m >= n >= 2. The quotient gets m - n + 1 limbs and
+    the remainder n limbs; neither may overlap the inputs.
+*/
+static void divmod32(const uint32_t u[], int m, const uint32_t v[], int n, uint32_t q[], uint32_t r[])
 {
-    __uint128_t dividend = *pdividend;
-    __uint128_t divisor = *pdivisor;
+    const uint64_t b = 1ull << 32;
+    uint32_t un[17], vn[16];
 
-    if (divisor == 0)
-        return 1;
+    // normalize so the top bit of the divisor is set; this keeps qhat at most 2 off
+    int s = __builtin_clz(v[n - 1]);
 
-    if (divisor == 1)
-    {
-        *remainder = 0;
-        *quotient = dividend;
-        return 0;
-    }
+    for (int i = n - 1; i > 0; i--)
+        vn[i] = (v[i] << s) | (uint32_t)((uint64_t)v[i - 1] >> (32 - s));
+    vn[0] = v[0] << s;
 
-    if (divisor == dividend)
-    {
-        *remainder = 0;
-        *quotient = 1;
-        return 0;
-    }
+    un[m] = (uint32_t)((uint64_t)u[m - 1] >> (32 - s));
+    for (int i = m - 1; i > 0; i--)
+        un[i] = (u[i] << s) | (uint32_t)((uint64_t)u[i - 1] >> (32 - s));
+    un[0] = u[0] << s;
 
-    if (dividend == 0 || dividend < divisor)
+    for (int j = m - n; j >= 0; j--)
     {
-        *remainder = dividend;
-        *quotient = 0;
-        return 0;
+        // estimate the quotient digit from the top two limbs
+        uint64_t top = ((uint64_t)un[j + n] << 32) | un[j + n - 1];
+        uint64_t qhat = top / vn[n - 1];
+        uint64_t rhat = top - qhat * vn[n - 1];
+
+        while (qhat >= b || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+        {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >= b)
+                break;
+        }
+
+        // multiply and subtract
+        int64_t t;
+        uint64_t k = 0;
+
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t p = qhat * vn[i];
+            t = (int64_t)un[i + j] - (int64_t)k - (int64_t)(p & 0xffffffff);
+            un[i + j] = t;
+            k = (p >> 32) - (t >> 32);
+        }
+
+        t = (int64_t)un[j + n] - (int64_t)k;
+        un[j + n] = t;
+
+        q[j] = qhat;
+
+        // the estimate was one too large; add back
+        if (t < 0)
+        {
+            q[j]--;
+            k = 0;
+
+            for (int i = 0; i < n; i++)
+            {
+                uint64_t sum = (uint64_t)un[i + j] + vn[i] + k;
+                un[i + j] = sum;
+                k = sum >> 32;
+            }
+
+            un[j + n] += k;
+        }
     }
 
-    __uint128_t q = 0, r = 0;
+    // unnormalize the remainder
+    for (int i = 0; i < n - 1; i++)
+        r[i] = (un[i] >> s) | (uint32_t)((uint64_t)un[i + 1] << 32 >> s);
+    r[n - 1] = un[n - 1] >> s;
+}
+
+/*
+    Unsigned division of the m limb value u by the n limb value v, with m, n >= 2. The quotient
+    gets m limbs and the remainder n limbs; neither may overlap the inputs. Returns 1 if the
+    divisor is zero.
+*/
+static int udivmod32_limbs(const uint32_t u[], int m, const uint32_t v[], int n, uint32_t q[], uint32_t r[])
+{
+    for (int i = 0; i < m; i++)
+        q[i] = 0;
+
+    for (int i = 0; i < n; i++)
+        r[i] = 0;
+
+    while (n > 0 && v[n - 1] == 0)
+        n--;
+
+    if (n == 0)
+        return 1;
+
+    while (m > 0 && u[m - 1] == 0)
+        m--;
 
-    for (int x = bits128(dividend) + 1; x > 0; x--)
+    if (m <= 2)
     {
-        q <<= 1;
-        r <<= 1;
+        // both fit in 64 bits (n <= m) or the dividend is smaller than the divisor
+        uint64_t dividend = m ? ((uint64_t)(m > 1 ? u[1] : 0) << 32) | u[0] : 0;
 
-        if ((dividend >> (x - 1)) & 1)
+        if (n > 2)
         {
-            r++;
+            r[0] = u[0];
+            r[1] = u[1];
         }
+        else
+        {
+            uint64_t divisor = ((uint64_t)(n > 1 ? v[1] : 0) << 32) | v[0];
+            uint64_t q64 = dividend / divisor;
+            uint64_t r64 = dividend - q64 * divisor;
+
+            q[0] = q64;
+            q[1] = q64 >> 32;
+            r[0] = r64;
+            r[1] = r64 >> 32;
+        }
+    }
+    else if (n == 1)
+    {
+        // short division by a single limb
+        uint64_t rem = 0;
 
-        if (r >= divisor)
+        for (int j = m - 1; j >= 0; j--)
         {
-            r -= divisor;
-            q++;
+            uint64_t cur = (rem << 32) | u[j];
+            q[j] = cur / v[0];
+            rem = cur - (uint64_t)q[j] * v[0];
         }
+
+        r[0] = rem;
+    }
+    else if (m < n)
+    {
+        for (int i = 0; i < m; i++)
+            r[i] = u[i];
+    }
+    else
+    {
+        divmod32(u, m, v, n, q, r);
     }
 
-    *quotient = q;
-    *remainder = r;
+    return 0;
+}
+
+/*
+    Unsigned division of len limb values. The dividend is copied first, so the quotient or
+    remainder may point to the dividend or divisor. The values are wider integer types, so
+    they are copied to and from the limbs with memcpy rather than accessed as uint32_t, which
+    would break strict aliasing. Returns 1 if the divisor is zero.
+*/
+static int udivmod32(const void *pdividend, const void *pdivisor, void *remainder, void *quotient, int len)
+{
+    uint32_t u[16], v[16], q[16], r[16];
+
+    __builtin_memcpy(u, pdividend, len * sizeof(uint32_t));
+    __builtin_memcpy(v, pdivisor, len * sizeof(uint32_t));
+
+    if (udivmod32_limbs(u, len, v, len, q, r))
+        return 1;
+
+    __builtin_memcpy(quotient, q, len * sizeof(uint32_t));
+    __builtin_memcpy(remainder, r, len * sizeof(uint32_t));
 
     return 0;
 }
 
+int udivmod128(__uint128_t *pdividend, __uint128_t *pdivisor, __uint128_t *remainder, __uint128_t *quotient)
+{
+    return udivmod32(pdividend, pdivisor, remainder, quotient, 4);
+}
+
 int sdivmod128(__uint128_t *pdividend, __uint128_t *pdivisor, __uint128_t *remainder, __uint128_t *quotient)
 {
     bool dividend_negative = ((uint8_t *)pdividend)[15] >= 128;
@@ -429,8 +553,6 @@ int sdivmod128(__uint128_t *pdividend, __uint128_t *pdivisor, __uint128_t *remai
 }
 
 typedef unsigned _BitInt(256) uint256_t;
-uint256_t const uint256_0 = (uint256_t)0;
-uint256_t const uint256_1 = (uint256_t)1;
 
 int bits256(uint256_t *value)
 {
@@ -448,60 +570,7 @@ int bits256(uint256_t *value)
 
 int udivmod256(uint256_t *pdividend, uint256_t *pdivisor, uint256_t *remainder, uint256_t *quotient)
 {
-    uint256_t dividend = *pdividend;
-    uint256_t divisor = *pdivisor;
-
-    if (divisor == uint256_0)
-        return 1;
-
-    if (divisor == uint256_1)
-    {
-        *remainder = uint256_0;
-        *quotient = dividend;
-        return 0;
-    }
-
-    if (divisor == dividend)
-    {
-        *remainder = uint256_0;
-        *quotient = uint256_1;
-        return 0;
-    }
-
-    if (dividend == uint256_0 || dividend < divisor)
-    {
-        *remainder = dividend;
-        *quotient = uint256_0;
-        return 0;
-    }
-
-    uint256_t q = uint256_0, r = dividend;
-
-    uint256_t copyd = divisor << (bits256(&dividend) - bits256(&divisor));
-    uint256_t adder = uint256_1 << (bits256(&dividend) - bits256(&divisor));
-
-    if (copyd > dividend)
-    {
-        copyd >>= 1;
-        adder >>= 1;
-    }
-
-    while (r >= divisor)
-    {
-        if (r >= copyd)
-        {
-            r -= copyd;
-            q |= adder;
-        }
-
-        copyd >>= 1;
-        adder >>= 1;
-    }
-
-    *quotient = q;
-    *remainder = r;
-
-    return 0;
+    return udivmod32(pdividend, pdivisor, remainder, quotient, 8);
 }
 
 int sdivmod256(uint256_t *pdividend, uint256_t *pdivisor, uint256_t *remainder, uint256_t *quotient)
@@ -543,8 +612,6 @@ int sdivmod256(uint256_t *pdividend, uint256_t *pdivisor, uint256_t *remainder,
 }
 
 typedef unsigned _BitInt(512) uint512_t;
-uint512_t const uint512_0 = (uint512_t)0;
-uint512_t const uint512_1 = (uint512_t)1;
 
 int bits512(uint512_t *value)
 {
@@ -562,60 +629,7 @@ int bits512(uint512_t *value)
 
 int udivmod512(uint512_t *pdividend, uint512_t *pdivisor, uint512_t *remainder, uint512_t *quotient)
 {
-    uint512_t dividend = *pdividend;
-    uint512_t divisor = *pdivisor;
-
-    if (divisor == uint512_0)
-        return 1;
-
-    if (divisor == uint512_1)
-    {
-        *remainder = uint512_0;
-        *quotient = dividend;
-        return 0;
-    }
-
-    if (divisor == dividend)
-    {
-        *remainder = uint512_0;
-        *quotient = uint512_1;
-        return 0;
-    }
-
-    if (dividend == uint512_0 || dividend < divisor)
-    {
-        *remainder = dividend;
-        *quotient = uint512_0;
-        return 0;
-    }
-
-    uint512_t q = uint512_0, r = dividend;
-
-    uint512_t copyd = divisor << (bits512(&dividend) - bits512(&divisor));
-    uint512_t adder = uint512_1 << (bits512(&dividend) - bits512(&divisor));
-
-    if (copyd > dividend)
-    {
-        copyd >>= 1;
-        adder >>= 1;
-    }
-
-    while (r >= divisor)
-    {
-        if (r >= copyd)
-        {
-            r -= copyd;
-            q |= adder;
-        }
-
-        copyd >>= 1;
-        adder >>= 1;
-    }
-
-    *quotient = q;
-    *remainder = r;
-
-    return 0;
+    return udivmod32(pdividend, pdivisor, remainder, quotient, 16);
 }
 
 int sdivmod512(uint512_t *pdividend, uint512_t *pdivisor, uint512_t *remainder, uint512_t *quotient)
@@ -655,3 +669,34 @@ int sdivmod512(uint512_t *pdividend, uint512_t *pdivisor, uint512_t *remainder,
 
     return 0;
 }
+
+/*
+    Solidity's addmod and mulmod. The intermediate sum or product is kept at full width (9 or
+    16 limbs) and reduced with a single division by the 8 limb modulus, rather than widening
+    everything to 512 bits. out must not overlap k. Returns 1 if the modulus is zero.
+*/
+int __addmod256(uint32_t x[8], uint32_t y[8], uint32_t k[8], uint32_t out[8])
+{
+    uint32_t sum[9], q[9];
+    uint64_t carry = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        carry += (uint64_t)x[i] + y[i];
+        sum[i] = carry;
+        carry >>= 32;
+    }
+
+    sum[8] = carry;
+
+    return udivmod32_limbs(sum, 9, k, 8, q, out);
+}
+
+int __mulmod256(uint32_t x[8], uint32_t y[8], uint32_t k[8], uint32_t out[8])
+{
+    uint32_t product[16], q[16];
+
+    mul32_columns(x, 8, y, 8, product, 16);
+
+    return udivmod32_limbs(product, 16, k, 8, q, out);
+}
@@ -88,163 +88,173 @@ char *uint2bin(char *output, uint8_t *input, uint32_t length)
     return output;
 }
 
-char *uint2dec(char *output, uint64_t val)
+// Two digits at a time, so only half as many divisions are needed
+static const char digit_pairs[200] = "0001020304050607080910111213141516171819"
+                                     "2021222324252627282930313233343536373839"
+                                     "4041424344454647484950515253545556575859"
+                                     "6061626364656667686970717273747576777879"
+                                     "8081828384858687888990919293949596979899";
+
+// Write val right-to-left, ending just before end. Returns the first digit written.
+static char *digits_rev(char *end, uint64_t val)
 {
-    char buf[20];
-    int len = 0;
-
-    // first generate the digits in left-to-right
-    do
+    while (val >= 100)
     {
-        buf[len++] = val % 10;
-        val /= 10;
-    } while (val);
+        uint32_t pair = (val % 100) * 2;
+        val /= 100;
+        *--end = digit_pairs[pair + 1];
+        *--end = digit_pairs[pair];
+    }
 
-    // now copy them in to right-to-left
-    while (len--)
+    if (val >= 10)
     {
-        *output++ = buf[len] + '0';
+        *--end = digit_pairs[val * 2 + 1];
+        *--end = digit_pairs[val * 2];
+    }
+    else
+    {
+        *--end = '0' + val;
     }
 
-    return output;
+    return end;
 }
 
-extern int udivmod128(const __uint128_t *dividend, const __uint128_t *divisor, __uint128_t *remainder,
-                      __uint128_t *quotient);
-
-char *uint128dec(char *output, __uint128_t val128)
+static char *copy_digits(char *output, char *start, char *end)
 {
-    // we want 1e19, how to declare such a constant in clang?
-    const __uint128_t billion = 10000000000;
-    const __uint128_t divisor = billion * 1000000000;
-    __uint128_t q, r;
-    char buf[40];
-    int len = 0;
+    while (start < end)
+    {
+        *output++ = *start++;
+    }
 
-    // first do the first 19 digits
+    return output;
+}
 
-    // divisor is never zero so we can ignore return value
-    udivmod128(&val128, &divisor, &r, &q);
+char *uint2dec(char *output, uint64_t val)
+{
+    char buf[20];
+    char *end = buf + sizeof(buf);
 
-    uint64_t val = r;
+    return copy_digits(output, digits_rev(end, val), end);
+}
 
-    do
-    {
-        buf[len++] = val % 10;
-        val /= 10;
-    } while (val);
+/*
+    Format an unsigned integer of len 32 bit limbs. While the value does not fit in 64 bits,
+    chunks of 9 digits are peeled off by dividing the limbs by 10^9. This is the largest power
+    of ten for which each step is a native 64 by 32 bit division, so there are no calls into
+    udivmod. The last 64 bits are formatted directly. The value is copied into the limbs
+    with memcpy, since it is a wider integer type and reading it as uint32_t would break
+    strict aliasing.
+*/
+static char *limbs2dec(char *output, const void *value, int len)
+{
+    uint32_t v[8];
+    char buf[80];
+    char *end = buf + sizeof(buf), *p = end;
 
-    /// next 19 digits
-    udivmod128(&q, &divisor, &r, &q);
+    __builtin_memcpy(v, value, len * sizeof(uint32_t));
 
-    val = r;
+    while (len > 0 && v[len - 1] == 0)
+        len--;
 
-    if (val)
+    while (len > 2)
     {
-        // add 0s
-        while (len < 19)
-        {
-            buf[len++] = 0;
-        }
+        uint64_t rem = 0;
 
-        do
+        for (int i = len - 1; i >= 0; i--)
         {
-            buf[len++] = val % 10;
-            val /= 10;
-        } while (val);
-    }
+            uint64_t cur = (rem << 32) | v[i];
+            v[i] = cur / 1000000000;
+            rem = cur - (uint64_t)v[i] * 1000000000;
+        }
 
-    val = q;
+        if (v[len - 1] == 0)
+            len--;
 
-    if (val)
-    {
-        // add 0s
-        while (len < 38)
+        // exactly 9 digits, including leading zeros
+        for (int i = 0; i < 4; i++)
         {
-            buf[len++] = 0;
+            uint32_t pair = (rem % 100) * 2;
+            rem /= 100;
+            *--p = digit_pairs[pair + 1];
+            *--p = digit_pairs[pair];
         }
 
-        do
-        {
-            buf[len++] = val % 10;
-            val /= 10;
-        } while (val);
+        *--p = '0' + rem;
     }
 
-    // now copy them in to right-to-left
-    while (len--)
-    {
-        *output++ = buf[len] + '0';
-    }
+    // the value was at least 2^64 if any chunks were written, so this is never a leading zero
+    uint64_t top = len == 2 ? ((uint64_t)v[1] << 32) | v[0] : len ? v[0] : 0;
 
-    return output;
+    p = digits_rev(p, top);
+
+    return copy_digits(output, p, end);
 }
 
-typedef unsigned _BitInt(256) uint256_t;
+char *uint128dec(char *output, __uint128_t val128)
+{
+    return limbs2dec(output, &val128, 4);
+}
 
-extern int udivmod256(const uint256_t *dividend, const uint256_t *divisor, uint256_t *remainder, uint256_t *quotient);
+typedef unsigned _BitInt(256) uint256_t;
 
 char *uint256dec(char *output, uint256_t *val256)
 {
-    // we want 1e19, how to declare such a constant in clang?
-    const uint256_t n1e10 = 10000000000;
-    const uint256_t n1e9 = 1000000000;
-    uint256_t divisor = n1e10 * n1e9;
-    uint256_t q = *val256, r;
-    char buf[80];
-    int len = 0;
+    return limbs2dec(output, val256, 8);
+}
 
-    // do the first digits
-    for (int digits = 0; digits < 76; digits += 19)
+static const char b58digits[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+/*
+    Solana addresses are always 32 bytes. Rather than the byte at a time algorithm below, load
+    them into 32 bit limbs and repeatedly divide by 58^5, which still fits in a limb. Each pass
+    is a native 64 by 32 bit division per limb and produces five digits.
+*/
+static void base58_encode_32(uint8_t *data, uint8_t *output, uint32_t output_len)
+{
+    const uint32_t b58pow5 = 58 * 58 * 58 * 58 * 58;
+    uint32_t limbs[8];
+    int len = 8;
+
+    // big endian bytes to little endian limbs
+    for (int i = 0; i < 8; i++)
     {
-        // divisor is never zero so we can ignore return value
-        udivmod256(&q, &divisor, &r, &q);
+        uint8_t *p = data + 28 - 4 * i;
+        limbs[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
 
-        uint64_t val = r;
+    uint32_t j = output_len;
 
-        // add 0s
-        while (len < digits)
-        {
-            buf[len++] = 0;
-        }
+    while (j > 0)
+    {
+        while (len > 0 && limbs[len - 1] == 0)
+            len--;
 
-        do
-        {
-            buf[len++] = val % 10;
-            val /= 10;
-        } while (val);
+        uint64_t rem = 0;
 
-        if (q == (uint256_t)0)
+        for (int i = len - 1; i >= 0; i--)
         {
-            break;
+            uint64_t cur = (rem << 32) | limbs[i];
+            limbs[i] = cur / b58pow5;
+            rem = cur - (uint64_t)limbs[i] * b58pow5;
         }
-    }
 
-    uint64_t val = q;
-
-    if (val)
-    {
-        do
+        for (int d = 0; d < 5 && j > 0; d++)
         {
-            buf[len++] = val % 10;
-            val /= 10;
-        } while (val);
-    }
-
-    // now copy them in to right-to-left
-    while (len--)
-    {
-        *output++ = buf[len] + '0';
+            output[--j] = b58digits[rem % 58];
+            rem /= 58;
+        }
     }
-
-    return output;
 }
 
-static const char b58digits[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-
 // https://github.com/bitcoin/libbase58/blob/b1dd03fa8d1be4be076bb6152325c6b5cf64f678/base58.c inspired this code.
 void base58_encode_solana_address(uint8_t *data, uint32_t data_len, uint8_t *output, uint32_t output_len)
 {
+    if (data_len == 32)
+    {
+        base58_encode_32(data, output, output_len);
+        return;
+    }
+
     uint32_t j, carry, zero_count = 0;
 
     while (zero_count < data_len && !data[zero_count])
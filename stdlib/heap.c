@@ -5,7 +5,7 @@
 #include <stdbool.h>
 #include "stdlib.h"
 
-#ifndef __wasm__
+#if !defined(__wasm__) || defined(TEST)
 #include "solana_sdk.h"
 #endif
 
@@ -17,7 +17,28 @@
 
   So I think we should avoid fragmentation by neighbour merging. The most
   costly is walking the doubly linked list looking for free space.
+
+  If the stdlib is built with -DHEAP_SIZE_CLASSES, free chunks are also kept
+  on segregated free lists, one per power-of-two size class, so that __malloc
+  does not have to walk past allocated chunks. The chunks stay on the address
+  ordered doubly linked list, so neighbour merging works exactly as before.
+
+  If the stdlib is built with -DHEAP_ARENA, the heap is a bump allocator
+  instead. Nearly nothing allocated during a call outlives the call, so
+  allocation is a pointer increment, and __free only returns memory when it is
+  the most recent allocation. Everything is discarded when the call ends.
+
+  If the stdlib is built with -DHEAP_PROFILE, allocation counts, bytes, peak usage and
+  the number of chunks walked to find free space are recorded in a struct heap_profile
+  at the very start of the heap, at a fixed address so that a test VM can read it after
+  a call. On Solana, __heap_report() logs it at the end of the entrypoint and when the
+  heap runs out of memory.
 */
+
+#if defined(HEAP_ARENA) && defined(HEAP_SIZE_CLASSES)
+#error "HEAP_ARENA and HEAP_SIZE_CLASSES cannot be combined"
+#endif
+
 struct chunk
 {
     struct chunk *next, *prev;
@@ -25,27 +46,314 @@ struct chunk
     uint32_t allocated;
 };
 
+#ifdef HEAP_SIZE_CLASSES
+// A free chunk stores its free list links in its (otherwise unused) payload
+struct free_links
+{
+    struct chunk *next_free, *prev_free;
+};
+
+// Size class n holds free chunks from 16 << n up to 32 << n bytes, class 0 has
+// everything smaller and the last class everything larger (the large object fallback)
+#define HEAP_CLASSES 10
+
+// Solana does not allow writable globals, so the free list heads live at the
+// start of the heap, before the first chunk
+struct heap_header
+{
+    struct chunk *free[HEAP_CLASSES];
+};
+
+#define HEAP_MIN_PAYLOAD ((sizeof(struct free_links) + 7) & ~7)
+#else
+#define HEAP_MIN_PAYLOAD 8
+#endif
+
+#ifdef TEST
+static uint64_t test_heap[(32 * 1024) / 8];
+#define HEAP_BASE ((uint8_t *)test_heap)
+#define HEAP_SIZE sizeof(test_heap)
+#elif defined(__wasm__)
+#define HEAP_BASE ((uint8_t *)0x10000)
+#define HEAP_SIZE (__builtin_wasm_memory_size(0) * 0x10000 - (size_t)HEAP_BASE)
+#else
+// Set by the compiler (--heap-size). Anything above the default 32 KiB has to be
+// requested by the transaction with a ComputeBudget RequestHeapFrame instruction.
+extern const uint32_t solang_heap_size;
+#define HEAP_BASE ((uint8_t *)0x300000000)
+#define HEAP_SIZE solang_heap_size
+#endif
+
+#ifdef HEAP_PROFILE
+// Solana does not allow writable globals, so like the other heap state the profile is
+// kept in the heap itself, before everything else
+#define PROFILE ((struct heap_profile *)HEAP_BASE)
+#define HEAP_DATA (HEAP_BASE + ((sizeof(struct heap_profile) + 7) & ~7))
+
+static inline void profile_init()
+{
+    __memset(PROFILE, 0, sizeof(struct heap_profile));
+}
+
+static inline void profile_alloc(uint32_t size, uint32_t length)
+{
+    PROFILE->allocs++;
+    PROFILE->bytes += size;
+    PROFILE->in_use += length;
+    if (PROFILE->in_use > PROFILE->peak)
+        PROFILE->peak = PROFILE->in_use;
+}
+
+static inline void profile_free(uint32_t length)
+{
+    PROFILE->frees++;
+    PROFILE->in_use -= length;
+}
+
+static inline void profile_realloc(uint32_t old_length, uint32_t new_length)
+{
+    PROFILE->reallocs++;
+    PROFILE->in_use += new_length - old_length;
+    if (PROFILE->in_use > PROFILE->peak)
+        PROFILE->peak = PROFILE->in_use;
+}
+
+static inline void profile_walk(uint32_t walked)
+{
+    PROFILE->walked += walked;
+    if (walked > PROFILE->max_walk)
+        PROFILE->max_walk = walked;
+}
+
+void __heap_report()
+{
+#if !defined(__wasm__) || defined(TEST)
+    sol_log("heap profile: allocs frees reallocs bytes peak");
+    sol_log_64(PROFILE->allocs, PROFILE->frees, PROFILE->reallocs, PROFILE->bytes, PROFILE->peak);
+    sol_log("heap profile: in_use walked max_walk");
+    sol_log_64(PROFILE->in_use, PROFILE->walked, PROFILE->max_walk, 0, 0);
+#endif
+}
+#else
+#define HEAP_DATA HEAP_BASE
+
+static inline void profile_init()
+{
+}
+
+static inline void profile_alloc(uint32_t size, uint32_t length)
+{
+}
+
+static inline void profile_free(uint32_t length)
+{
+}
+
+static inline void profile_realloc(uint32_t old_length, uint32_t new_length)
+{
+}
+
+static inline void profile_walk(uint32_t walked)
+{
+}
+#endif
+
+static void out_of_heap_memory()
+{
+#ifdef HEAP_PROFILE
+    __heap_report();
+#endif
+
+    // go bang
 #ifdef __wasm__
-#define HEAP_START ((struct chunk *)0x10000)
+    __builtin_unreachable();
+#else
+    sol_log("out of heap memory");
+    sol_panic();
+#endif
+}
+
+#ifdef HEAP_ARENA
+struct arena
+{
+    uint8_t *cursor, *end;
+};
+
+// Each allocation remembers its length so __realloc() knows how much to copy
+struct arena_chunk
+{
+    uint32_t length;
+    uint32_t reserved;
+};
+
+#define ARENA ((struct arena *)HEAP_DATA)
+
+// The size of a chunk with this length, which cannot overflow even for the largest length
+static inline uint64_t arena_chunk_size(uint32_t length)
+{
+    return sizeof(struct arena_chunk) + (((uint64_t)length + 7) & ~7ull);
+}
+
+static inline uint8_t *arena_chunk_end(struct arena_chunk *cur)
+{
+    return (uint8_t *)cur + arena_chunk_size(cur->length);
+}
 
 void __init_heap()
 {
-    struct chunk *first = HEAP_START;
-    first->next = first->prev = NULL;
-    first->allocated = false;
-    first->length = (uint32_t)(__builtin_wasm_memory_size(0) * 0x10000 - (size_t)first - sizeof(struct chunk));
+    profile_init();
+    ARENA->cursor = HEAP_DATA + sizeof(struct arena);
+    ARENA->end = HEAP_BASE + HEAP_SIZE;
+}
+
+void *__attribute__((noinline)) __malloc(uint32_t size)
+{
+    uint64_t chunk_size = arena_chunk_size(size);
+
+    // check before writing the chunk header, which may itself not fit
+    if (chunk_size > (uint64_t)(ARENA->end - ARENA->cursor))
+    {
+        out_of_heap_memory();
+        return NULL;
+    }
+
+    struct arena_chunk *cur = (struct arena_chunk *)ARENA->cursor;
+
+    cur->length = size;
+
+    ARENA->cursor += chunk_size;
+    profile_alloc(size, chunk_size);
+
+    return ++cur;
+}
+
+void __attribute__((noinline)) __free(void *m)
+{
+    struct arena_chunk *cur = m;
+    cur--;
+    // only the most recent allocation can be given back
+    if (m && arena_chunk_end(cur) == ARENA->cursor)
+    {
+        profile_free(ARENA->cursor - (uint8_t *)cur);
+        ARENA->cursor = (uint8_t *)cur;
+    }
+}
+
+void *__realloc(void *m, uint32_t size)
+{
+    struct arena_chunk *cur = m;
+
+    cur--;
+
+    if (arena_chunk_end(cur) == ARENA->cursor)
+    {
+        // the most recent allocation can grow or shrink in place
+        uint64_t chunk_size = arena_chunk_size(size);
+
+        if (chunk_size > (uint64_t)(ARENA->end - (uint8_t *)cur))
+        {
+            out_of_heap_memory();
+            return NULL;
+        }
+
+        cur->length = size;
+
+        profile_realloc(ARENA->cursor - (uint8_t *)cur, chunk_size);
+        ARENA->cursor = (uint8_t *)cur + chunk_size;
+        return m;
+    }
+    else
+    {
+        uint32_t len = cur->length;
+
+        if (size < len)
+            len = size;
+
+        void *n = __malloc(size);
+
+        // the new allocation is counted by __malloc()
+        profile_realloc(0, 0);
+
+        // allocations are 8 byte aligned and padded to 8 bytes, so copy whole words
+        if (len)
+            __memcpy8(n, m, (len + 7) / 8);
+        return n;
+    }
+}
+#else
+
+#ifdef HEAP_SIZE_CLASSES
+#define HEAP_HEADER ((struct heap_header *)HEAP_DATA)
+#define HEAP_START ((struct chunk *)(HEAP_DATA + sizeof(struct heap_header)))
+#else
+#define HEAP_START ((struct chunk *)HEAP_DATA)
+#endif
+
+#ifdef HEAP_SIZE_CLASSES
+static inline struct free_links *free_links(struct chunk *cur)
+{
+    return (struct free_links *)(cur + 1);
+}
+
+static inline uint32_t size_class(uint32_t length)
+{
+    if (length < 32)
+        return 0;
+
+    uint32_t class = 31 - __builtin_clz(length) - 4;
+
+    return class < HEAP_CLASSES ? class : HEAP_CLASSES - 1;
+}
+
+static void free_list_insert(struct chunk *cur)
+{
+    struct chunk **head = &HEAP_HEADER->free[size_class(cur->length)];
+    struct free_links *links = free_links(cur);
+
+    links->prev_free = NULL;
+    if ((links->next_free = *head) != NULL)
+        free_links(*head)->prev_free = cur;
+    *head = cur;
+}
+
+static void free_list_remove(struct chunk *cur)
+{
+    struct free_links *links = free_links(cur);
+
+    if (links->prev_free)
+        free_links(links->prev_free)->next_free = links->next_free;
+    else
+        HEAP_HEADER->free[size_class(cur->length)] = links->next_free;
+
+    if (links->next_free)
+        free_links(links->next_free)->prev_free = links->prev_free;
 }
 #else
-#define HEAP_START ((struct chunk *)0x300000000)
+static inline void free_list_insert(struct chunk *cur)
+{
+}
+
+static inline void free_list_remove(struct chunk *cur)
+{
+}
+#endif
 
 void __init_heap()
 {
+    profile_init();
+
     struct chunk *first = HEAP_START;
     first->next = first->prev = NULL;
     first->allocated = false;
-    first->length = (32 * 1024) - sizeof(struct chunk);
-}
+    first->length = (uint32_t)(HEAP_SIZE - ((uint8_t *)first - HEAP_BASE) - sizeof(struct chunk));
+
+#ifdef HEAP_SIZE_CLASSES
+    for (int i = 0; i < HEAP_CLASSES; i++)
+        HEAP_HEADER->free[i] = NULL;
+
+    free_list_insert(first);
 #endif
+}
 
 void __attribute__((noinline)) __free(void *m)
 {
@@ -53,11 +361,13 @@ void __attribute__((noinline)) __free(void *m)
     cur--;
     if (m)
     {
+        profile_free(cur->length);
         cur->allocated = false;
         struct chunk *next = cur->next;
         if (next && !next->allocated)
         {
             // merge with next
+            free_list_remove(next);
             if ((cur->next = next->next) != NULL)
                 cur->next->prev = cur;
             cur->length += next->length + sizeof(struct chunk);
@@ -68,10 +378,15 @@ void __attribute__((noinline)) __free(void *m)
         if (prev && !prev->allocated)
         {
             // merge with previous
+            free_list_remove(prev);
             prev->next = next;
-            next->prev = prev;
+            if (next)
+                next->prev = prev;
             prev->length += cur->length + sizeof(struct chunk);
+            cur = prev;
         }
+
+        free_list_insert(cur);
     }
 }
 
@@ -80,7 +395,10 @@ static void shrink_chunk(struct chunk *cur, uint32_t size)
     // round up to nearest 8 bytes
     size = (size + 7) & ~7;
 
-    if (cur->length - size >= (8 + sizeof(struct chunk)))
+    if (size < HEAP_MIN_PAYLOAD)
+        size = HEAP_MIN_PAYLOAD;
+
+    if (cur->length - size >= (HEAP_MIN_PAYLOAD + sizeof(struct chunk)))
     {
         // split and return
         void *data = (cur + 1);
@@ -92,31 +410,73 @@ static void shrink_chunk(struct chunk *cur, uint32_t size)
         new->allocated = false;
         new->length = cur->length - size - sizeof(struct chunk);
         cur->length = size;
+        free_list_insert(new);
     }
 }
 
-void *__attribute__((noinline)) __malloc(uint32_t size)
+#ifdef HEAP_SIZE_CLASSES
+static struct chunk *find_chunk(uint32_t size)
+{
+    uint32_t class = size_class(size);
+
+    uint32_t walked = 0;
+
+    // chunks in the same size class may still be too small
+    for (struct chunk *cur = HEAP_HEADER->free[class]; cur; cur = free_links(cur)->next_free)
+    {
+        walked++;
+
+        if (size <= cur->length)
+        {
+            profile_walk(walked);
+            return cur;
+        }
+    }
+
+    profile_walk(walked);
+
+    // any chunk in a larger size class will do
+    while (++class < HEAP_CLASSES)
+    {
+        if (HEAP_HEADER->free[class])
+            return HEAP_HEADER->free[class];
+    }
+
+    return NULL;
+}
+#else
+static inline struct chunk *find_chunk(uint32_t size)
 {
     struct chunk *cur = HEAP_START;
+    uint32_t walked = 0;
 
     while (cur && (cur->allocated || size > cur->length))
+    {
         cur = cur->next;
+        walked++;
+    }
+
+    profile_walk(walked);
+
+    return cur;
+}
+#endif
+
+void *__attribute__((noinline)) __malloc(uint32_t size)
+{
+    struct chunk *cur = find_chunk(size);
 
     if (cur)
     {
+        free_list_remove(cur);
         shrink_chunk(cur, size);
         cur->allocated = true;
+        profile_alloc(size, cur->length);
         return ++cur;
     }
     else
     {
-        // go bang
-#ifdef __wasm__
-        __builtin_unreachable();
-#else
-        sol_log("out of heap memory");
-        sol_panic();
-#endif
+        out_of_heap_memory();
         return NULL;
     }
 }
@@ -131,13 +491,17 @@ void *__realloc(void *m, uint32_t size)
 
     if (next && !next->allocated && size <= (cur->length + next->length + sizeof(struct chunk)))
     {
+        uint32_t old_length = cur->length;
+
         // merge with next
+        free_list_remove(next);
         cur->next = next->next;
         if (cur->next)
             cur->next->prev = cur;
         cur->length += next->length + sizeof(struct chunk);
         // resplit ..
         shrink_chunk(cur, size);
+        profile_realloc(old_length, cur->length);
         return m;
     }
     else
@@ -151,6 +515,9 @@ void *__realloc(void *m, uint32_t size)
 
         void *n = __malloc(size);
 
+        // the move itself is counted by __malloc() and __free()
+        profile_realloc(0, 0);
+
         // __memcpy8() copies 8 bytes at once; round up to the nearest 8 bytes
         // this is permitted because allocations are always aligned on 8 byte
         // boundaries anyway.
@@ -159,3 +526,168 @@ void *__realloc(void *m, uint32_t size)
         return n;
     }
 }
+#endif
+
+#if defined(TEST) && !defined(BENCH)
+// To run the test:
+// clang -DTEST -DSOL_TEST -O3 -Wall heap.c stdlib.c -o test_heap && ./test_heap
+// and again with -DHEAP_SIZE_CLASSES, -DHEAP_ARENA and -DHEAP_PROFILE
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef HEAP_ARENA
+static void validate_heap(uint8_t *ptrs[100], uint32_t lens[100])
+{
+    for (int i = 0; i < 100; i++)
+    {
+        if (ptrs[i])
+        {
+            struct arena_chunk *cur = (struct arena_chunk *)ptrs[i] - 1;
+
+            assert(cur->length == lens[i] && arena_chunk_end(cur) <= ARENA->cursor);
+
+            for (uint32_t x = 0; x < lens[i]; x++)
+                assert(ptrs[i][x] == i);
+        }
+    }
+}
+#else
+static void validate_heap(uint8_t *ptrs[100], uint32_t lens[100])
+{
+    struct chunk *cur = HEAP_START, *prev = NULL;
+    uint32_t total = 0, free_chunks = 0, in_use = 0, live = 0;
+
+    while (cur)
+    {
+        assert(cur->prev == prev);
+        assert(cur->length >= HEAP_MIN_PAYLOAD && (cur->length & 7) == 0);
+        assert(!cur->next || (uint8_t *)cur->next == (uint8_t *)(cur + 1) + cur->length);
+
+        total += cur->length + sizeof(struct chunk);
+
+        if (cur->allocated)
+        {
+            bool found = false;
+
+            in_use += cur->length;
+            live++;
+
+            for (int i = 0; i < 100; i++)
+            {
+                if (ptrs[i] == (uint8_t *)(cur + 1))
+                {
+                    assert(!found && lens[i] <= cur->length);
+                    found = true;
+
+                    for (uint32_t x = 0; x < lens[i]; x++)
+                        assert(ptrs[i][x] == i);
+                }
+            }
+
+            assert(found);
+        }
+        else
+        {
+            // free chunks are always merged with their neighbours
+            assert(!prev || prev->allocated);
+            free_chunks++;
+        }
+
+        prev = cur;
+        cur = cur->next;
+    }
+
+    assert(total == HEAP_SIZE - ((uint8_t *)HEAP_START - HEAP_BASE));
+
+#ifdef HEAP_PROFILE
+    assert(PROFILE->in_use == in_use && PROFILE->peak >= in_use);
+    assert(PROFILE->allocs - PROFILE->frees == live);
+#endif
+
+#ifdef HEAP_SIZE_CLASSES
+    // every free chunk must be on the free list of its size class
+    for (uint32_t class = 0; class < HEAP_CLASSES; class++)
+    {
+        struct chunk *prev_free = NULL;
+
+        for (cur = HEAP_HEADER->free[class]; cur; cur = free_links(cur)->next_free)
+        {
+            assert(!cur->allocated && size_class(cur->length) == class);
+            assert(free_links(cur)->prev_free == prev_free);
+            prev_free = cur;
+            free_chunks--;
+        }
+    }
+
+    assert(free_chunks == 0);
+#endif
+}
+#endif
+
+int main()
+{
+    uint8_t *ptrs[100];
+    uint32_t lens[100];
+
+    memset(ptrs, 0, sizeof(ptrs));
+
+    int seed = time(NULL);
+    printf("seed: %d\n", seed);
+    srand(seed);
+
+    __init_heap();
+
+#ifdef HEAP_ARENA
+    // an allocation which ends exactly at the end of the heap still fits
+    uint32_t rest = ARENA->end - ARENA->cursor - sizeof(struct arena_chunk);
+    assert(__malloc(rest) && ARENA->cursor == ARENA->end);
+    __init_heap();
+#endif
+
+    for (int step = 0; step < 1000000; step++)
+    {
+        validate_heap(ptrs, lens);
+
+#ifdef HEAP_ARENA
+        // the arena never reuses memory, so start over regularly, as a new call would
+        if (step % 100 == 0)
+        {
+            __init_heap();
+            memset(ptrs, 0, sizeof(ptrs));
+        }
+#endif
+
+        int n = rand() % 100;
+        uint32_t size = (rand() % 200) + 1;
+
+        if (ptrs[n] == NULL)
+        {
+            ptrs[n] = __malloc(size);
+            memset(ptrs[n], n, size);
+            lens[n] = size;
+        }
+        else if (rand() % 2)
+        {
+            __free(ptrs[n]);
+            ptrs[n] = NULL;
+        }
+        else
+        {
+            ptrs[n] = __realloc(ptrs[n], size);
+            if (size > lens[n])
+                memset(ptrs[n] + lens[n], n, size - lens[n]);
+            lens[n] = size;
+        }
+    }
+
+    printf("No error found after 1000000 steps\n");
+}
+
+void sol_panic_(const char *s, uint64_t len, uint64_t line, uint64_t column)
+{
+    printf("panic: %s line %lld\n", s, line);
+    abort();
+}
+#endif
@@ -54,19 +54,6 @@
 #define RIPEMD160_DIGEST_SIZE 20
 #define BLOCK_SIZE 64
 
-typedef struct
-{
-    uint32_t h[5];   /* The current hash state */
-    uint64_t length; /* Total number of _bits_ (not bytes) added to the
-                           hash.  This includes bits that have been buffered
-                           but not not fed through the compression function yet. */
-    union {
-        uint32_t w[16];
-        uint8_t b[64];
-    } buf;
-    uint8_t bufpos; /* number of bytes currently in the buffer */
-} ripemd160_state;
-
 /* cyclic left-shift the 32-bit word n left by s bits */
 #define ROL(s, n) (((n) << (s)) | ((n) >> (32 - (s))))
 
@@ -84,50 +71,11 @@ static const uint32_t initial_h[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x1
  * -------+-----------+-----------+-----------+-----------+-----------
  *  left  |    id     |    rho    |   rho^2   |   rho^3   |   rho^4
  *  right |    pi     |   rho pi  |  rho^2 pi |  rho^3 pi |  rho^4 pi
+ *
+ * The compression function below is fully unrolled, so the message word indices and the
+ * shifts (which come with the permutations pre-applied) are written out in each step.
  */
 
-/* Left line */
-static const uint8_t RL[5][16] = {
-    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, /* Round 1: id */
-    {7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8}, /* Round 2: rho */
-    {3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12}, /* Round 3: rho^2 */
-    {1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2}, /* Round 4: rho^3 */
-    {4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13}  /* Round 5: rho^4 */
-};
-
-/* Right line */
-static const uint8_t RR[5][16] = {
-    {5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12}, /* Round 1: pi */
-    {6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2}, /* Round 2: rho pi */
-    {15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13}, /* Round 3: rho^2 pi */
-    {8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14}, /* Round 4: rho^3 pi */
-    {12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11}  /* Round 5: rho^4 pi */
-};
-
-/*
- * Shifts - Since we don't actually re-order the message words according to
- * the permutations above (we could, but it would be slower), these tables
- * come with the permutations pre-applied.
- */
-
-/* Shifts, left line */
-static const uint8_t SL[5][16] = {
-    {11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8}, /* Round 1 */
-    {7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12}, /* Round 2 */
-    {11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5}, /* Round 3 */
-    {11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12}, /* Round 4 */
-    {9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6}  /* Round 5 */
-};
-
-/* Shifts, right line */
-static const uint8_t SR[5][16] = {
-    {8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6}, /* Round 1 */
-    {9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11}, /* Round 2 */
-    {9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5}, /* Round 3 */
-    {15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8}, /* Round 4 */
-    {8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11}  /* Round 5 */
-};
-
 /* Boolean functions */
 
 #define F1(x, y, z) ((x) ^ (y) ^ (z))
@@ -137,219 +85,282 @@ static const uint8_t SR[5][16] = {
 #define F5(x, y, z) ((x) ^ ((y) | ~(z)))
 
 /* Round constants, left line */
-static const uint32_t KL[5] = {
-    0x00000000u, /* Round 1: 0 */
-    0x5A827999u, /* Round 2: floor(2**30 * sqrt(2)) */
-    0x6ED9EBA1u, /* Round 3: floor(2**30 * sqrt(3)) */
-    0x8F1BBCDCu, /* Round 4: floor(2**30 * sqrt(5)) */
-    0xA953FD4Eu  /* Round 5: floor(2**30 * sqrt(7)) */
-};
+#define KL1 0x00000000u /* Round 1: 0 */
+#define KL2 0x5A827999u /* Round 2: floor(2**30 * sqrt(2)) */
+#define KL3 0x6ED9EBA1u /* Round 3: floor(2**30 * sqrt(3)) */
+#define KL4 0x8F1BBCDCu /* Round 4: floor(2**30 * sqrt(5)) */
+#define KL5 0xA953FD4Eu /* Round 5: floor(2**30 * sqrt(7)) */
 
 /* Round constants, right line */
-static const uint32_t KR[5] = {
-    0x50A28BE6u, /* Round 1: floor(2**30 * cubert(2)) */
-    0x5C4DD124u, /* Round 2: floor(2**30 * cubert(3)) */
-    0x6D703EF3u, /* Round 3: floor(2**30 * cubert(5)) */
-    0x7A6D76E9u, /* Round 4: floor(2**30 * cubert(7)) */
-    0x00000000u  /* Round 5: 0 */
-};
-
-/* The RIPEMD160 compression function.  Operates on self->buf */
-static void ripemd160_compress(ripemd160_state *self)
+#define KR1 0x50A28BE6u /* Round 1: floor(2**30 * cubert(2)) */
+#define KR2 0x5C4DD124u /* Round 2: floor(2**30 * cubert(3)) */
+#define KR3 0x6D703EF3u /* Round 3: floor(2**30 * cubert(5)) */
+#define KR4 0x7A6D76E9u /* Round 4: floor(2**30 * cubert(7)) */
+#define KR5 0x00000000u /* Round 5: 0 */
+
+/* One step of either line. Rather than shifting the chaining variables along after each
+ * step, the next step is called with its arguments rotated by one. */
+#define STEP(f, a, b, c, d, e, x, s, k)                                                                                \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        a = ROL(s, a + f(b, c, d) + (x) + (k)) + e;                                                                    \
+        c = ROL(10, c);                                                                                                \
+    } while (0)
+
+/* The RIPEMD160 compression function, on the 16 little-endian words X */
+static void ripemd160_compress(uint32_t h[5], const uint32_t X[16])
 {
-    uint8_t w, round;
     uint32_t T;
-    uint32_t AL, BL, CL, DL, EL; /* left line */
-    uint32_t AR, BR, CR, DR, ER; /* right line */
+    uint32_t al, bl, cl, dl, el; /* left line */
+    uint32_t ar, br, cr, dr, er; /* right line */
 
     /* Load the left and right lines with the initial state */
-    AL = AR = self->h[0];
-    BL = BR = self->h[1];
-    CL = CR = self->h[2];
-    DL = DR = self->h[3];
-    EL = ER = self->h[4];
+    al = ar = h[0];
+    bl = br = h[1];
+    cl = cr = h[2];
+    dl = dr = h[3];
+    el = er = h[4];
 
+    /* Left line */
     /* Round 1 */
-    round = 0;
-    for (w = 0; w < 16; w++)
-    { /* left line */
-        T = ROL(SL[round][w], AL + F1(BL, CL, DL) + self->buf.w[RL[round][w]] + KL[round]) + EL;
-        AL = EL;
-        EL = DL;
-        DL = ROL(10, CL);
-        CL = BL;
-        BL = T;
-    }
-    for (w = 0; w < 16; w++)
-    { /* right line */
-        T = ROL(SR[round][w], AR + F5(BR, CR, DR) + self->buf.w[RR[round][w]] + KR[round]) + ER;
-        AR = ER;
-        ER = DR;
-        DR = ROL(10, CR);
-        CR = BR;
-        BR = T;
-    }
+    STEP(F1, al, bl, cl, dl, el, X[0], 11, KL1);
+    STEP(F1, el, al, bl, cl, dl, X[1], 14, KL1);
+    STEP(F1, dl, el, al, bl, cl, X[2], 15, KL1);
+    STEP(F1, cl, dl, el, al, bl, X[3], 12, KL1);
+    STEP(F1, bl, cl, dl, el, al, X[4], 5, KL1);
+    STEP(F1, al, bl, cl, dl, el, X[5], 8, KL1);
+    STEP(F1, el, al, bl, cl, dl, X[6], 7, KL1);
+    STEP(F1, dl, el, al, bl, cl, X[7], 9, KL1);
+    STEP(F1, cl, dl, el, al, bl, X[8], 11, KL1);
+    STEP(F1, bl, cl, dl, el, al, X[9], 13, KL1);
+    STEP(F1, al, bl, cl, dl, el, X[10], 14, KL1);
+    STEP(F1, el, al, bl, cl, dl, X[11], 15, KL1);
+    STEP(F1, dl, el, al, bl, cl, X[12], 6, KL1);
+    STEP(F1, cl, dl, el, al, bl, X[13], 7, KL1);
+    STEP(F1, bl, cl, dl, el, al, X[14], 9, KL1);
+    STEP(F1, al, bl, cl, dl, el, X[15], 8, KL1);
 
     /* Round 2 */
-    round++;
-    for (w = 0; w < 16; w++)
-    { /* left line */
-        T = ROL(SL[round][w], AL + F2(BL, CL, DL) + self->buf.w[RL[round][w]] + KL[round]) + EL;
-        AL = EL;
-        EL = DL;
-        DL = ROL(10, CL);
-        CL = BL;
-        BL = T;
-    }
-    for (w = 0; w < 16; w++)
-    { /* right line */
-        T = ROL(SR[round][w], AR + F4(BR, CR, DR) + self->buf.w[RR[round][w]] + KR[round]) + ER;
-        AR = ER;
-        ER = DR;
-        DR = ROL(10, CR);
-        CR = BR;
-        BR = T;
-    }
+    STEP(F2, el, al, bl, cl, dl, X[7], 7, KL2);
+    STEP(F2, dl, el, al, bl, cl, X[4], 6, KL2);
+    STEP(F2, cl, dl, el, al, bl, X[13], 8, KL2);
+    STEP(F2, bl, cl, dl, el, al, X[1], 13, KL2);
+    STEP(F2, al, bl, cl, dl, el, X[10], 11, KL2);
+    STEP(F2, el, al, bl, cl, dl, X[6], 9, KL2);
+    STEP(F2, dl, el, al, bl, cl, X[15], 7, KL2);
+    STEP(F2, cl, dl, el, al, bl, X[3], 15, KL2);
+    STEP(F2, bl, cl, dl, el, al, X[12], 7, KL2);
+    STEP(F2, al, bl, cl, dl, el, X[0], 12, KL2);
+    STEP(F2, el, al, bl, cl, dl, X[9], 15, KL2);
+    STEP(F2, dl, el, al, bl, cl, X[5], 9, KL2);
+    STEP(F2, cl, dl, el, al, bl, X[2], 11, KL2);
+    STEP(F2, bl, cl, dl, el, al, X[14], 7, KL2);
+    STEP(F2, al, bl, cl, dl, el, X[11], 13, KL2);
+    STEP(F2, el, al, bl, cl, dl, X[8], 12, KL2);
 
     /* Round 3 */
-    round++;
-    for (w = 0; w < 16; w++)
-    { /* left line */
-        T = ROL(SL[round][w], AL + F3(BL, CL, DL) + self->buf.w[RL[round][w]] + KL[round]) + EL;
-        AL = EL;
-        EL = DL;
-        DL = ROL(10, CL);
-        CL = BL;
-        BL = T;
-    }
-    for (w = 0; w < 16; w++)
-    { /* right line */
-        T = ROL(SR[round][w], AR + F3(BR, CR, DR) + self->buf.w[RR[round][w]] + KR[round]) + ER;
-        AR = ER;
-        ER = DR;
-        DR = ROL(10, CR);
-        CR = BR;
-        BR = T;
-    }
+    STEP(F3, dl, el, al, bl, cl, X[3], 11, KL3);
+    STEP(F3, cl, dl, el, al, bl, X[10], 13, KL3);
+    STEP(F3, bl, cl, dl, el, al, X[14], 6, KL3);
+    STEP(F3, al, bl, cl, dl, el, X[4], 7, KL3);
+    STEP(F3, el, al, bl, cl, dl, X[9], 14, KL3);
+    STEP(F3, dl, el, al, bl, cl, X[15], 9, KL3);
+    STEP(F3, cl, dl, el, al, bl, X[8], 13, KL3);
+    STEP(F3, bl, cl, dl, el, al, X[1], 15, KL3);
+    STEP(F3, al, bl, cl, dl, el, X[2], 14, KL3);
+    STEP(F3, el, al, bl, cl, dl, X[7], 8, KL3);
+    STEP(F3, dl, el, al, bl, cl, X[0], 13, KL3);
+    STEP(F3, cl, dl, el, al, bl, X[6], 6, KL3);
+    STEP(F3, bl, cl, dl, el, al, X[13], 5, KL3);
+    STEP(F3, al, bl, cl, dl, el, X[11], 12, KL3);
+    STEP(F3, el, al, bl, cl, dl, X[5], 7, KL3);
+    STEP(F3, dl, el, al, bl, cl, X[12], 5, KL3);
 
     /* Round 4 */
-    round++;
-    for (w = 0; w < 16; w++)
-    { /* left line */
-        T = ROL(SL[round][w], AL + F4(BL, CL, DL) + self->buf.w[RL[round][w]] + KL[round]) + EL;
-        AL = EL;
-        EL = DL;
-        DL = ROL(10, CL);
-        CL = BL;
-        BL = T;
-    }
-    for (w = 0; w < 16; w++)
-    { /* right line */
-        T = ROL(SR[round][w], AR + F2(BR, CR, DR) + self->buf.w[RR[round][w]] + KR[round]) + ER;
-        AR = ER;
-        ER = DR;
-        DR = ROL(10, CR);
-        CR = BR;
-        BR = T;
-    }
+    STEP(F4, cl, dl, el, al, bl, X[1], 11, KL4);
+    STEP(F4, bl, cl, dl, el, al, X[9], 12, KL4);
+    STEP(F4, al, bl, cl, dl, el, X[11], 14, KL4);
+    STEP(F4, el, al, bl, cl, dl, X[10], 15, KL4);
+    STEP(F4, dl, el, al, bl, cl, X[0], 14, KL4);
+    STEP(F4, cl, dl, el, al, bl, X[8], 15, KL4);
+    STEP(F4, bl, cl, dl, el, al, X[12], 9, KL4);
+    STEP(F4, al, bl, cl, dl, el, X[4], 8, KL4);
+    STEP(F4, el, al, bl, cl, dl, X[13], 9, KL4);
+    STEP(F4, dl, el, al, bl, cl, X[3], 14, KL4);
+    STEP(F4, cl, dl, el, al, bl, X[7], 5, KL4);
+    STEP(F4, bl, cl, dl, el, al, X[15], 6, KL4);
+    STEP(F4, al, bl, cl, dl, el, X[14], 8, KL4);
+    STEP(F4, el, al, bl, cl, dl, X[5], 6, KL4);
+    STEP(F4, dl, el, al, bl, cl, X[6], 5, KL4);
+    STEP(F4, cl, dl, el, al, bl, X[2], 12, KL4);
 
     /* Round 5 */
-    round++;
-    for (w = 0; w < 16; w++)
-    { /* left line */
-        T = ROL(SL[round][w], AL + F5(BL, CL, DL) + self->buf.w[RL[round][w]] + KL[round]) + EL;
-        AL = EL;
-        EL = DL;
-        DL = ROL(10, CL);
-        CL = BL;
-        BL = T;
-    }
-    for (w = 0; w < 16; w++)
-    { /* right line */
-        T = ROL(SR[round][w], AR + F1(BR, CR, DR) + self->buf.w[RR[round][w]] + KR[round]) + ER;
-        AR = ER;
-        ER = DR;
-        DR = ROL(10, CR);
-        CR = BR;
-        BR = T;
-    }
+    STEP(F5, bl, cl, dl, el, al, X[4], 9, KL5);
+    STEP(F5, al, bl, cl, dl, el, X[0], 15, KL5);
+    STEP(F5, el, al, bl, cl, dl, X[5], 5, KL5);
+    STEP(F5, dl, el, al, bl, cl, X[9], 11, KL5);
+    STEP(F5, cl, dl, el, al, bl, X[7], 6, KL5);
+    STEP(F5, bl, cl, dl, el, al, X[12], 8, KL5);
+    STEP(F5, al, bl, cl, dl, el, X[2], 13, KL5);
+    STEP(F5, el, al, bl, cl, dl, X[10], 12, KL5);
+    STEP(F5, dl, el, al, bl, cl, X[14], 5, KL5);
+    STEP(F5, cl, dl, el, al, bl, X[1], 12, KL5);
+    STEP(F5, bl, cl, dl, el, al, X[3], 13, KL5);
+    STEP(F5, al, bl, cl, dl, el, X[8], 14, KL5);
+    STEP(F5, el, al, bl, cl, dl, X[11], 11, KL5);
+    STEP(F5, dl, el, al, bl, cl, X[6], 8, KL5);
+    STEP(F5, cl, dl, el, al, bl, X[15], 5, KL5);
+    STEP(F5, bl, cl, dl, el, al, X[13], 6, KL5);
+
+    /* Right line */
+    /* Round 1 */
+    STEP(F5, ar, br, cr, dr, er, X[5], 8, KR1);
+    STEP(F5, er, ar, br, cr, dr, X[14], 9, KR1);
+    STEP(F5, dr, er, ar, br, cr, X[7], 9, KR1);
+    STEP(F5, cr, dr, er, ar, br, X[0], 11, KR1);
+    STEP(F5, br, cr, dr, er, ar, X[9], 13, KR1);
+    STEP(F5, ar, br, cr, dr, er, X[2], 15, KR1);
+    STEP(F5, er, ar, br, cr, dr, X[11], 15, KR1);
+    STEP(F5, dr, er, ar, br, cr, X[4], 5, KR1);
+    STEP(F5, cr, dr, er, ar, br, X[13], 7, KR1);
+    STEP(F5, br, cr, dr, er, ar, X[6], 7, KR1);
+    STEP(F5, ar, br, cr, dr, er, X[15], 8, KR1);
+    STEP(F5, er, ar, br, cr, dr, X[8], 11, KR1);
+    STEP(F5, dr, er, ar, br, cr, X[1], 14, KR1);
+    STEP(F5, cr, dr, er, ar, br, X[10], 14, KR1);
+    STEP(F5, br, cr, dr, er, ar, X[3], 12, KR1);
+    STEP(F5, ar, br, cr, dr, er, X[12], 6, KR1);
+
+    /* Round 2 */
+    STEP(F4, er, ar, br, cr, dr, X[6], 9, KR2);
+    STEP(F4, dr, er, ar, br, cr, X[11], 13, KR2);
+    STEP(F4, cr, dr, er, ar, br, X[3], 15, KR2);
+    STEP(F4, br, cr, dr, er, ar, X[7], 7, KR2);
+    STEP(F4, ar, br, cr, dr, er, X[0], 12, KR2);
+    STEP(F4, er, ar, br, cr, dr, X[13], 8, KR2);
+    STEP(F4, dr, er, ar, br, cr, X[5], 9, KR2);
+    STEP(F4, cr, dr, er, ar, br, X[10], 11, KR2);
+    STEP(F4, br, cr, dr, er, ar, X[14], 7, KR2);
+    STEP(F4, ar, br, cr, dr, er, X[15], 7, KR2);
+    STEP(F4, er, ar, br, cr, dr, X[8], 12, KR2);
+    STEP(F4, dr, er, ar, br, cr, X[12], 7, KR2);
+    STEP(F4, cr, dr, er, ar, br, X[4], 6, KR2);
+    STEP(F4, br, cr, dr, er, ar, X[9], 15, KR2);
+    STEP(F4, ar, br, cr, dr, er, X[1], 13, KR2);
+    STEP(F4, er, ar, br, cr, dr, X[2], 11, KR2);
+
+    /* Round 3 */
+    STEP(F3, dr, er, ar, br, cr, X[15], 9, KR3);
+    STEP(F3, cr, dr, er, ar, br, X[5], 7, KR3);
+    STEP(F3, br, cr, dr, er, ar, X[1], 15, KR3);
+    STEP(F3, ar, br, cr, dr, er, X[3], 11, KR3);
+    STEP(F3, er, ar, br, cr, dr, X[7], 8, KR3);
+    STEP(F3, dr, er, ar, br, cr, X[14], 6, KR3);
+    STEP(F3, cr, dr, er, ar, br, X[6], 6, KR3);
+    STEP(F3, br, cr, dr, er, ar, X[9], 14, KR3);
+    STEP(F3, ar, br, cr, dr, er, X[11], 12, KR3);
+    STEP(F3, er, ar, br, cr, dr, X[8], 13, KR3);
+    STEP(F3, dr, er, ar, br, cr, X[12], 5, KR3);
+    STEP(F3, cr, dr, er, ar, br, X[2], 14, KR3);
+    STEP(F3, br, cr, dr, er, ar, X[10], 13, KR3);
+    STEP(F3, ar, br, cr, dr, er, X[0], 13, KR3);
+    STEP(F3, er, ar, br, cr, dr, X[4], 7, KR3);
+    STEP(F3, dr, er, ar, br, cr, X[13], 5, KR3);
+
+    /* Round 4 */
+    STEP(F2, cr, dr, er, ar, br, X[8], 15, KR4);
+    STEP(F2, br, cr, dr, er, ar, X[6], 5, KR4);
+    STEP(F2, ar, br, cr, dr, er, X[4], 8, KR4);
+    STEP(F2, er, ar, br, cr, dr, X[1], 11, KR4);
+    STEP(F2, dr, er, ar, br, cr, X[3], 14, KR4);
+    STEP(F2, cr, dr, er, ar, br, X[11], 14, KR4);
+    STEP(F2, br, cr, dr, er, ar, X[15], 6, KR4);
+    STEP(F2, ar, br, cr, dr, er, X[0], 14, KR4);
+    STEP(F2, er, ar, br, cr, dr, X[5], 6, KR4);
+    STEP(F2, dr, er, ar, br, cr, X[12], 9, KR4);
+    STEP(F2, cr, dr, er, ar, br, X[2], 12, KR4);
+    STEP(F2, br, cr, dr, er, ar, X[13], 9, KR4);
+    STEP(F2, ar, br, cr, dr, er, X[9], 12, KR4);
+    STEP(F2, er, ar, br, cr, dr, X[7], 5, KR4);
+    STEP(F2, dr, er, ar, br, cr, X[10], 15, KR4);
+    STEP(F2, cr, dr, er, ar, br, X[14], 8, KR4);
 
-    /* Final mixing stage */
-    T = self->h[1] + CL + DR;
-    self->h[1] = self->h[2] + DL + ER;
-    self->h[2] = self->h[3] + EL + AR;
-    self->h[3] = self->h[4] + AL + BR;
-    self->h[4] = self->h[0] + BL + CR;
-    self->h[0] = T;
-
-    /* Clear the buffer and wipe the temporary variables */
-    T = AL = BL = CL = DL = EL = AR = BR = CR = DR = ER = 0;
-    __memset(&self->buf, 0, sizeof(self->buf));
-    self->bufpos = 0;
+    /* Round 5 */
+    STEP(F1, br, cr, dr, er, ar, X[12], 8, KR5);
+    STEP(F1, ar, br, cr, dr, er, X[15], 5, KR5);
+    STEP(F1, er, ar, br, cr, dr, X[10], 12, KR5);
+    STEP(F1, dr, er, ar, br, cr, X[4], 9, KR5);
+    STEP(F1, cr, dr, er, ar, br, X[1], 12, KR5);
+    STEP(F1, br, cr, dr, er, ar, X[5], 5, KR5);
+    STEP(F1, ar, br, cr, dr, er, X[8], 14, KR5);
+    STEP(F1, er, ar, br, cr, dr, X[7], 6, KR5);
+    STEP(F1, dr, er, ar, br, cr, X[6], 8, KR5);
+    STEP(F1, cr, dr, er, ar, br, X[2], 13, KR5);
+    STEP(F1, br, cr, dr, er, ar, X[13], 6, KR5);
+    STEP(F1, ar, br, cr, dr, er, X[14], 5, KR5);
+    STEP(F1, er, ar, br, cr, dr, X[0], 15, KR5);
+    STEP(F1, dr, er, ar, br, cr, X[3], 13, KR5);
+    STEP(F1, cr, dr, er, ar, br, X[9], 11, KR5);
+    STEP(F1, br, cr, dr, er, ar, X[11], 11, KR5);
+
+    /* Final mixing stage. After 80 steps the rotation is back where it started. */
+    T = h[1] + cl + dr;
+    h[1] = h[2] + dl + er;
+    h[2] = h[3] + el + ar;
+    h[3] = h[4] + al + br;
+    h[4] = h[0] + bl + cr;
+    h[0] = T;
 }
 
-static void ripemd160_update(ripemd160_state *self, const unsigned char *p, int length)
+/*
+ * Hash in a single pass. Whole blocks are compressed straight from the input when it is word
+ * aligned; only unaligned blocks and the final padded block are copied.
+ */
+void ripemd160(void *in, int inlen, void *out)
 {
-    unsigned int bytes_needed;
+    uint32_t h[5];
+    const uint8_t *p = in;
+    uint32_t length = inlen;
+    union {
+        uint32_t w[16];
+        uint8_t b[64];
+    } buf;
 
-    while (length > 0)
-    {
-        /* Figure out how many bytes we need to fill the internal buffer. */
-        bytes_needed = 64 - self->bufpos;
+    __memcpy(h, initial_h, sizeof(initial_h));
 
-        if ((unsigned int)length >= bytes_needed)
+    for (; length >= BLOCK_SIZE; length -= BLOCK_SIZE, p += BLOCK_SIZE)
+    {
+        if (!((uintptr_t)p & 3))
         {
-            /* We have enough bytes, so copy them into the internal buffer and run
-             * the compression function. */
-            __memcpy(&self->buf.b[self->bufpos], p, bytes_needed);
-            self->bufpos += bytes_needed;
-            self->length += bytes_needed << 3; /* length is in bits */
-            p += bytes_needed;
-            ripemd160_compress(self);
-            length -= bytes_needed;
-            continue;
+            ripemd160_compress(h, (const uint32_t *)p);
+        }
+        else
+        {
+            __memcpy(buf.b, p, BLOCK_SIZE);
+            ripemd160_compress(h, buf.w);
         }
-
-        /* We do not have enough bytes to fill the internal buffer.
-         * Copy what's there and return. */
-        __memcpy(&self->buf.b[self->bufpos], p, length);
-        self->bufpos += length;
-        self->length += length << 3; /* length is in bits */
-        return;
     }
-}
 
-static void ripemd160_digest(ripemd160_state *self, unsigned char *out)
-{
     /* Append the padding */
-    self->buf.b[self->bufpos++] = 0x80;
+    __memset(buf.b, 0, BLOCK_SIZE);
+    __memcpy(buf.b, p, length);
+    buf.b[length] = 0x80;
 
-    if (self->bufpos > 56)
+    if (length >= 56)
     {
-        self->bufpos = 64;
-        ripemd160_compress(self);
+        ripemd160_compress(h, buf.w);
+        __memset(buf.b, 0, BLOCK_SIZE);
     }
 
-    /* Append the length */
-    self->buf.w[14] = (uint32_t)(self->length & 0xFFFFffffu);
-    self->buf.w[15] = (uint32_t)((self->length >> 32) & 0xFFFFffffu);
-    self->bufpos = 64;
-    ripemd160_compress(self);
+    /* Append the length in bits */
+    uint64_t bits = (uint64_t)(uint32_t)inlen << 3;
 
-    /* Copy the final state into the output buffer */
-    __memcpy(out, &self->h, RIPEMD160_DIGEST_SIZE);
-}
+    buf.w[14] = (uint32_t)bits;
+    buf.w[15] = (uint32_t)(bits >> 32);
+    ripemd160_compress(h, buf.w);
 
-void ripemd160(void *in, int inlen, void *out)
-{
-    ripemd160_state state;
-
-    __memset(&state, 0, sizeof(state));
-    __memcpy(&state.h, initial_h, sizeof(initial_h));
-
-    ripemd160_update(&state, in, inlen);
-
-    ripemd160_digest(&state, out);
+    /* Copy the final state into the output buffer */
+    __memcpy(out, h, RIPEMD160_DIGEST_SIZE);
 }
 
 /* vim:set ts=4 sw=4 sts=4 expandtab: */
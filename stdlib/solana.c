@@ -8,10 +8,6 @@
 extern uint64_t solang_dispatch(SolParameters *param);
 extern void __init_heap();
 
-// The address 'SysvarC1ock11111111111111111111111111111111' base58 decoded
-static const SolPubkey clock_address = {0x06, 0xa7, 0xd5, 0x17, 0x18, 0xc7, 0x74, 0xc9, 0x28, 0x56, 0x63,
-                                        0x98, 0x69, 0x1d, 0x5e, 0xb6, 0x8b, 0x5e, 0xb8, 0xa3, 0x9b, 0x4b,
-                                        0x6d, 0x5c, 0x73, 0x55, 0x5b, 0x21, 0x00, 0x00, 0x00, 0x00};
 // The address 'Sysvar1nstructions1111111111111111111111111' base58 decoded
 static const SolPubkey instructions_address = {0x06, 0xa7, 0xd5, 0x17, 0x18, 0x7b, 0xd1, 0x66, 0x35, 0xda, 0xd4,
                                                0x04, 0x55, 0xfd, 0xc2, 0xc0, 0xc1, 0x24, 0xc6, 0x8f, 0x21, 0x56,
@@ -33,41 +29,61 @@ uint64_t entrypoint(const uint8_t *input)
         return ret;
     }
 
-    params.ka_clock = NULL;
+    // sysvars are looked up on first use
+    params.clock = NULL;
     params.ka_instructions = NULL;
+    params.ed25519_signatures = NULL;
 
-    for (int account_no = 0; account_no < params.ka_num; account_no++)
-    {
-        const SolAccountInfo *acc = &params.ka[account_no];
+    __init_heap();
 
-        if (SolPubkey_same(&clock_address, acc->key))
-        {
-            params.ka_clock = acc;
-        }
-        else if (SolPubkey_same(&instructions_address, acc->key))
-        {
-            params.ka_instructions = acc;
-        }
-    }
+#ifdef HEAP_PROFILE
+    ret = solang_dispatch(&params);
 
-    __init_heap();
+    __heap_report();
 
+    return ret;
+#else
     return solang_dispatch(&params);
+#endif
 }
 
 #endif
 
+// Find a sysvar account by its key. This is done the first time the sysvar is needed rather
+// than in the entrypoint, so functions which do not use sysvars do not pay for the search.
+static const SolAccountInfo *find_sysvar(SolParameters *params, const SolPubkey *key)
+{
+    for (int account_no = 0; account_no < params->ka_num && account_no < SOL_ARRAY_SIZE(params->ka); account_no++)
+    {
+        const SolAccountInfo *acc = &params->ka[account_no];
+
+        if (SolPubkey_same(key, acc->key))
+        {
+            return acc;
+        }
+    }
+
+    return NULL;
+}
+
+// This selects the bucket of storage mappings keyed by address, so it must return the same value
+// as older versions did: the sum of the address bytes. The bytes are summed a word at a time in
+// 16 bit lanes, which cannot overflow for 32 bytes.
 uint64_t address_hash(uint8_t data[32])
 {
-    uint64_t hash = 0;
-    uint32_t i;
+    const uint64_t lanes = 0x00ff00ff00ff00ffull;
+    uint64_t sum = 0;
 
-    for (i = 0; i < 32; i++)
+    for (int i = 0; i < 4; i++)
     {
-        hash += data[i];
+        uint64_t word;
+
+        __builtin_memcpy(&word, data + i * 8, sizeof(word));
+
+        sum += (word & lanes) + ((word >> 8) & lanes);
     }
 
-    return hash;
+    return (sum * 0x0001000100010001ull) >> 48;
 }
 
 bool address_equal(void *a, void *b)
@@ -95,9 +111,6 @@ struct ed25519_instruction_sig
     uint16_t message_offset;
     uint16_t message_size;
     uint16_t message_instruction_index;
-    uint8_t public_key[SIZE_PUBKEY];
-    uint8_t signature[64];
-    uint8_t message[0];
 };
 
 struct ed25519_instruction
@@ -107,64 +120,141 @@ struct ed25519_instruction
     struct ed25519_instruction_sig sig[0];
 };
 
-uint64_t signature_verify(uint8_t *public_key, struct vector *message, struct vector *signature, SolParameters *params)
+#ifndef TEST
+
+/*
+    An open addressing hash table of the signatures checked by ed25519 program instructions in
+    this transaction, keyed by public key. It is built the first time a signature is verified,
+    so verifying many signatures does not parse the instructions sysvar each time.
+*/
+struct ed25519_entry
 {
-    if (params->ka_instructions)
+    uint8_t *instr;
+    struct ed25519_instruction_sig *sig;
+};
+
+struct ed25519_index
+{
+    uint32_t mask;
+    struct ed25519_entry entries[0];
+};
+
+// Walk the ed25519 program instructions. If index is NULL, only count the signatures.
+static uint32_t ed25519_walk(const SolAccountInfo *ka_instructions, struct ed25519_index *index)
+{
+    uint16_t *data = (uint16_t *)ka_instructions->data;
+    uint64_t instr_count = data[0];
+    uint32_t count = 0;
+
+    // for each instruction
+    for (uint64_t instr_no = 0; instr_no < instr_count; instr_no++)
     {
-        uint16_t *data = (uint16_t *)params->ka_instructions->data;
+        uint8_t *instr = ka_instructions->data + data[1 + instr_no];
 
-        uint64_t instr_count = data[0];
+        // step over the accounts
+        uint64_t accounts = *((uint16_t *)instr);
 
-        // for each instruction
-        for (uint64_t instr_no = 0; instr_no < instr_count; instr_no++)
+        instr += accounts * 33 + 2;
+
+        if (sol_memcmp(&ed25519_address, instr, sizeof(ed25519_address)))
         {
-            uint8_t *instr = params->ka_instructions->data + data[1 + instr_no];
+            continue;
+        }
 
-            // step over the accounts
-            uint64_t accounts = *((uint16_t *)instr);
+        // step over program_id and length
+        instr += 2 + 32;
 
-            instr += accounts * 33 + 2;
+        struct ed25519_instruction *ed25519 = (struct ed25519_instruction *)instr;
 
-            if (sol_memcmp(&ed25519_address, instr, sizeof(ed25519_address)))
-            {
+        for (uint64_t sig_no = 0; sig_no < ed25519->num_signatures; sig_no++)
+        {
+            struct ed25519_instruction_sig *sig = &ed25519->sig[sig_no];
+
+            if (sig->public_key_instruction_index != instr_no || sig->signature_instruction_index != instr_no ||
+                sig->message_instruction_index != instr_no)
                 continue;
+
+            count++;
+
+            if (index)
+            {
+                uint32_t slot = __hash_bytes(instr + sig->public_key_offset, SIZE_PUBKEY) & index->mask;
+
+                while (index->entries[slot].sig)
+                    slot = (slot + 1) & index->mask;
+
+                index->entries[slot].instr = instr;
+                index->entries[slot].sig = sig;
             }
+        }
+    }
 
-            // step over program_id and length
-            instr += 2 + 32;
+    return count;
+}
 
-            struct ed25519_instruction *ed25519 = (struct ed25519_instruction *)instr;
+static struct ed25519_index *ed25519_build_index(const SolAccountInfo *ka_instructions)
+{
+    uint32_t count = ed25519_walk(ka_instructions, NULL);
+    uint32_t size = 2;
 
-            for (uint64_t sig_no = 0; sig_no < ed25519->num_signatures; sig_no++)
-            {
-                struct ed25519_instruction_sig *sig = &ed25519->sig[sig_no];
+    // keep the table at most half full
+    while (size < count * 2)
+        size *= 2;
 
-                if (sig->public_key_instruction_index != instr_no || sig->signature_instruction_index != instr_no ||
-                    sig->message_instruction_index != instr_no)
-                    continue;
+    uint32_t bytes = sizeof(struct ed25519_index) + size * sizeof(struct ed25519_entry);
+    struct ed25519_index *index = __malloc(bytes);
 
-                if (sol_memcmp(public_key, instr + sig->public_key_offset, SIZE_PUBKEY))
-                {
-                    continue;
-                }
+    __memset(index, 0, bytes);
+    index->mask = size - 1;
 
-                if (sol_memcmp(signature->data, instr + sig->signature_offset, 64))
-                {
-                    continue;
-                }
+    ed25519_walk(ka_instructions, index);
 
-                if (sig->message_size != message->len)
-                {
-                    continue;
-                }
+    return index;
+}
 
-                if (sol_memcmp(message->data, instr + sig->message_offset, message->len))
-                {
-                    continue;
-                }
+uint64_t signature_verify(uint8_t *public_key, struct vector *message, struct vector *signature, SolParameters *params)
+{
+    if (!params->ka_instructions)
+    {
+        params->ka_instructions = find_sysvar(params, &instructions_address);
+    }
 
-                return 0;
+    if (params->ka_instructions)
+    {
+        if (!params->ed25519_signatures)
+        {
+            params->ed25519_signatures = ed25519_build_index(params->ka_instructions);
+        }
+
+        struct ed25519_index *index = params->ed25519_signatures;
+        uint32_t slot = __hash_bytes(public_key, SIZE_PUBKEY) & index->mask;
+
+        for (; index->entries[slot].sig; slot = (slot + 1) & index->mask)
+        {
+            uint8_t *instr = index->entries[slot].instr;
+            struct ed25519_instruction_sig *sig = index->entries[slot].sig;
+
+            if (sol_memcmp(public_key, instr + sig->public_key_offset, SIZE_PUBKEY))
+            {
+                continue;
+            }
+
+            if (sol_memcmp(signature->data, instr + sig->signature_offset, 64))
+            {
+                continue;
             }
+
+            if (sig->message_size != message->len)
+            {
+                continue;
+            }
+
+            if (sol_memcmp(message->data, instr + sig->message_offset, message->len))
+            {
+                continue;
+            }
+
+            return 0;
         }
     }
 
@@ -184,22 +274,32 @@ struct clock_layout
 
 struct clock_layout *sol_clock(SolParameters *params)
 {
-    if (!params->ka_clock)
+    // read the clock with a syscall, so no clock account is needed
+    if (!params->clock)
     {
-        sol_log("clock account missing from transaction");
-        sol_panic();
-    }
+        struct clock_layout *clock = __malloc(sizeof(struct clock_layout));
 
-    struct clock_layout *clock_data = (struct clock_layout *)params->ka_clock->data;
+        if (sol_get_clock_sysvar(clock))
+        {
+            sol_log("failed to read clock sysvar");
+            sol_panic();
+        }
 
-    return clock_data;
+        params->clock = clock;
+    }
+
+    return params->clock;
 }
 
+#endif
+
 struct account_data_header
 {
     uint32_t magic;
-    uint32_t returndata_len;
-    uint32_t returndata_offset;
+    // Offset of the first free chunk which is not the trailing chunk, or 0 if there are none
+    uint32_t free_list;
+    // Offset of the trailing chunk, or 0 if the free index has not been built yet
+    uint32_t heap_tail;
     uint32_t heap_offset;
 };
 
@@ -210,6 +310,12 @@ struct account_data_header
 // time it is called.
 // We don't expect the account data to exceed 4GB so we use 32 bit offsets.
 // The account data can grow so the last entry always has length = 0 and offset_next = 0.
+//
+// So that allocating does not have to walk every chunk, free chunks other than the trailing
+// chunk are kept on a second doubly-linked list, whose links are stored in the chunk's unused
+// data. The heads of both are stored in the account data header, in the words which older
+// versions used for return data. Accounts written before the free list existed have zeros or
+// stale return data there, and their index is built by walking the heap once.
 struct chunk
 {
     uint32_t offset_next, offset_prev;
@@ -217,8 +323,142 @@ struct chunk
     uint32_t allocated;
 };
 
+struct free_links
+{
+    uint32_t next, prev;
+};
+
 #define ROUND_UP(n, d) (((n) + (d) - 1) & ~(d - 1))
 
+static inline struct free_links *links(void *data, uint32_t offset)
+{
+    return data + offset + sizeof(struct chunk);
+}
+
+static void free_list_insert(void *data, uint32_t offset)
+{
+    struct account_data_header *hdr = data;
+    struct free_links *l = links(data, offset);
+
+    l->prev = 0;
+    l->next = hdr->free_list;
+
+    if (l->next)
+        links(data, l->next)->prev = offset;
+
+    hdr->free_list = offset;
+}
+
+static void free_list_remove(void *data, uint32_t offset)
+{
+    struct account_data_header *hdr = data;
+    struct free_links *l = links(data, offset);
+
+    if (l->prev)
+        links(data, l->prev)->next = l->next;
+    else
+        hdr->free_list = l->next;
+
+    if (l->next)
+        links(data, l->next)->prev = l->prev;
+}
+
+// Is this the offset of a chunk, i.e. is it linked from its neighbours? Every chunk header
+// read lies below limit, which must not be past the end of the account data.
+static bool is_chunk(void *data, uint32_t offset, uint32_t limit)
+{
+    struct account_data_header *hdr = data;
+    struct chunk *chunk = data + offset;
+
+    if (offset < hdr->heap_offset || offset >= limit || limit - offset < sizeof(struct chunk) ||
+        ((offset - hdr->heap_offset) & 7))
+        return false;
+
+    if (chunk->offset_prev)
+    {
+        if (chunk->offset_prev < hdr->heap_offset || chunk->offset_prev >= offset ||
+            offset - chunk->offset_prev < sizeof(struct chunk))
+            return false;
+
+        if (((struct chunk *)(data + chunk->offset_prev))->offset_next != offset)
+            return false;
+    }
+    else if (offset != hdr->heap_offset)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Are the free list head and trailing chunk offset in the header valid? Older versions stored
+// the return data length and offset in these words, so both are checked against the heap and
+// the account length rather than trusted.
+static bool account_data_index_valid(void *data, uint32_t data_len)
+{
+    struct account_data_header *hdr = data;
+    uint32_t tail = hdr->heap_tail;
+    struct chunk *chunk = data + tail;
+
+    if (data_len < sizeof(struct chunk) || tail > data_len - sizeof(struct chunk) ||
+        !is_chunk(data, tail, tail + sizeof(struct chunk)))
+        return false;
+
+    if (chunk->offset_next || chunk->length || chunk->allocated)
+        return false;
+
+    if (hdr->free_list)
+    {
+        uint32_t offset = hdr->free_list;
+
+        if (!is_chunk(data, offset, tail))
+            return false;
+
+        chunk = data + offset;
+
+        if (chunk->allocated || chunk->offset_next <= offset || chunk->offset_next > tail ||
+            chunk->offset_next - offset < sizeof(struct chunk) + sizeof(struct free_links))
+            return false;
+
+        if (((struct chunk *)(data + chunk->offset_next))->offset_prev != offset)
+            return false;
+
+        if (links(data, offset)->prev)
+            return false;
+    }
+
+    return true;
+}
+
+// Make sure the free list and trailing chunk offset in the header are valid, building them if
+// the account was written before they existed.
+static void account_data_index(void *data, uint32_t data_len)
+{
+    struct account_data_header *hdr = data;
+
+    if (account_data_index_valid(data, data_len))
+        return;
+
+    hdr->free_list = 0;
+    uint32_t offset = hdr->heap_offset;
+
+    for (;;)
+    {
+        struct chunk *chunk = data + offset;
+
+        if (!chunk->offset_next)
+        {
+            hdr->heap_tail = offset;
+            return;
+        }
+
+        if (!chunk->allocated)
+            free_list_insert(data, offset);
+
+        offset = chunk->offset_next;
+    }
+}
+
 uint64_t account_data_alloc(SolAccountInfo *ai, uint32_t size, uint32_t *res)
 {
     void *data = ai->data;
@@ -230,87 +470,87 @@ uint64_t account_data_alloc(SolAccountInfo *ai, uint32_t size, uint32_t *res)
         return 0;
     }
 
-    uint32_t offset = hdr->heap_offset;
+    account_data_index(data, ai->data_len);
 
     uint32_t alloc_size = ROUND_UP(size, 8);
 
-    uint32_t offset_prev = 0;
-
-    for (;;)
+    // first fit from the free chunks
+    for (uint32_t offset = hdr->free_list; offset; offset = links(data, offset)->next)
     {
         struct chunk *chunk = data + offset;
+        uint32_t space = chunk->offset_next - offset - sizeof(struct chunk);
 
-        if (!chunk->allocated)
+        if (space < alloc_size)
         {
-            if (!chunk->length)
-            {
-                offset += sizeof(struct chunk);
+            // too small
+            continue;
+        }
 
-                if (offset + alloc_size + sizeof(struct chunk) >= ai->data_len)
-                {
-                    return ERROR_ACCOUNT_DATA_TOO_SMALL;
-                }
+        free_list_remove(data, offset);
 
-                chunk->offset_next = offset + alloc_size;
-                chunk->offset_prev = offset_prev;
-                chunk->allocated = true;
-                chunk->length = size;
+        if (alloc_size + sizeof(struct chunk) + 8 > space)
+        {
+            // just right
+            chunk->allocated = true;
+            chunk->length = size;
 
-                struct chunk *next = data + chunk->offset_next;
+            *res = offset + sizeof(struct chunk);
+            return 0;
+        }
+        else
+        {
+            // too big, split. The next chunk is allocated, else we would have merged with it
+            uint32_t next = chunk->offset_next;
+            uint32_t prev = offset;
 
-                next->offset_prev = offset - sizeof(struct chunk);
-                next->length = 0;
-                next->offset_next = 0;
-                next->allocated = false;
+            uint32_t next_offset = offset + sizeof(struct chunk) + alloc_size;
 
-                *res = offset;
-                return 0;
-            }
-            else if (chunk->length < alloc_size)
-            {
-                // too small
-            }
-            else if (alloc_size + sizeof(struct chunk) + 8 > chunk->length)
-            {
-                // just right
-                chunk->allocated = true;
-                chunk->length = size;
+            chunk->offset_next = next_offset;
+            chunk->length = size;
+            chunk->allocated = true;
 
-                *res = offset + sizeof(struct chunk);
-                return 0;
-            }
-            else
-            {
-                // too big, split
-                uint32_t next = chunk->offset_next;
-                uint32_t prev = offset;
+            chunk = data + next_offset;
+            chunk->offset_prev = prev;
+            chunk->offset_next = next;
+            chunk->length = next - next_offset - sizeof(struct chunk);
+            chunk->allocated = false;
 
-                uint32_t next_offset = offset + sizeof(struct chunk) + alloc_size;
+            free_list_insert(data, next_offset);
 
-                chunk->offset_next = next_offset;
-                chunk->length = size;
-                chunk->allocated = true;
+            chunk = data + next;
+            chunk->offset_prev = next_offset;
 
-                chunk = data + next_offset;
-                chunk->offset_prev = prev;
-                chunk->offset_next = next;
-                chunk->length = next - next_offset - sizeof(struct chunk);
-                chunk->allocated = false;
+            *res = offset + sizeof(struct chunk);
+            return 0;
+        }
+    }
 
-                if (next)
-                {
-                    struct chunk *chunk = data + next;
-                    chunk->offset_prev = next_offset;
-                }
+    // nothing free fits, so grow into the trailing chunk
+    uint32_t offset = hdr->heap_tail;
+    struct chunk *chunk = data + offset;
 
-                *res = offset + sizeof(struct chunk);
-                return 0;
-            }
-        }
+    offset += sizeof(struct chunk);
 
-        offset_prev = offset;
-        offset = chunk->offset_next;
+    if (offset + alloc_size + sizeof(struct chunk) >= ai->data_len)
+    {
+        return ERROR_ACCOUNT_DATA_TOO_SMALL;
     }
+
+    chunk->offset_next = offset + alloc_size;
+    chunk->allocated = true;
+    chunk->length = size;
+
+    struct chunk *next = data + chunk->offset_next;
+
+    next->offset_prev = offset - sizeof(struct chunk);
+    next->length = 0;
+    next->offset_next = 0;
+    next->allocated = false;
+
+    hdr->heap_tail = chunk->offset_next;
+
+    *res = offset;
+    return 0;
 }
 
 uint32_t account_data_len(void *data, uint32_t offset)
@@ -326,19 +566,24 @@ uint32_t account_data_len(void *data, uint32_t offset)
     return chunk->length;
 }
 
-void account_data_free(void *data, uint32_t offset)
+void account_data_free(SolAccountInfo *ai, uint32_t offset)
 {
     // Nothing to do
     if (!offset)
         return;
 
+    void *data = ai->data;
+    struct account_data_header *hdr = data;
+
+    account_data_index(data, ai->data_len);
+
     offset -= sizeof(struct chunk);
 
     struct chunk *chunk = data + offset;
 
     chunk->allocated = false;
 
-    // merge with previous chunk?
+    // merge with previous chunk? It cannot be the trailing chunk
     if (chunk->offset_prev)
     {
         struct chunk *prev = data + chunk->offset_prev;
@@ -346,59 +591,78 @@ void account_data_free(void *data, uint32_t offset)
         if (!prev->allocated)
         {
             // merge
+            free_list_remove(data, chunk->offset_prev);
+
             offset = chunk->offset_prev;
 
-            if (chunk->offset_next)
-            {
-                prev->length = chunk->offset_next - offset - sizeof(struct chunk);
-                prev->offset_next = chunk->offset_next;
+            prev->length = chunk->offset_next - offset - sizeof(struct chunk);
+            prev->offset_next = chunk->offset_next;
 
-                struct chunk *next = data + chunk->offset_next;
+            struct chunk *next = data + chunk->offset_next;
 
-                next->offset_prev = offset;
-            }
-            else
-            {
-                prev->offset_next = 0;
-                prev->length = 0;
-            }
+            next->offset_prev = offset;
 
             chunk = prev;
         }
     }
 
     // merge with next chunk?
-    if (chunk->offset_next)
+    struct chunk *next = data + chunk->offset_next;
+
+    if (!next->allocated)
     {
-        struct chunk *next = data + chunk->offset_next;
+        // merge
+        if (next->offset_next)
+        {
+            free_list_remove(data, chunk->offset_next);
+
+            chunk->offset_next = next->offset_next;
+
+            chunk->length = chunk->offset_next - offset - sizeof(struct chunk);
+
+            struct chunk *next = data + chunk->offset_next;
 
-        if (!next->allocated)
+            next->offset_prev = offset;
+        }
+        else
         {
-            // merge
-            if (next->offset_next)
-            {
-                chunk->offset_next = next->offset_next;
+            // we are the trailing chunk now
+            chunk->offset_next = 0;
+            chunk->length = 0;
 
-                chunk->length = chunk->offset_next - offset - sizeof(struct chunk);
+            hdr->heap_tail = offset;
+            return;
+        }
+    }
 
-                struct chunk *next = data + chunk->offset_next;
+    free_list_insert(data, offset);
+}
 
-                next->offset_prev = offset;
-            }
-            else
-            {
-                chunk->offset_next = 0;
-                chunk->length = 0;
-            }
+// Copy to a lower address, where the source and destination may overlap. Chunks are 8 byte
+// aligned, so this can go a word at a time.
+static void move_down(uint8_t *dest, const uint8_t *src, uint32_t length)
+{
+    if (!(((uintptr_t)dest | (uintptr_t)src) & 7))
+    {
+        for (; length >= 8; length -= 8)
+        {
+            *(uint64_t *)dest = *(const uint64_t *)src;
+            dest += 8;
+            src += 8;
         }
     }
+
+    while (length--)
+    {
+        *dest++ = *src++;
+    }
 }
 
 uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size, uint32_t *res)
 {
     if (!size)
     {
-        account_data_free(ai->data, offset);
+        account_data_free(ai, offset);
         *res = 0;
         return 0;
     }
@@ -409,6 +673,9 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
     }
 
     void *data = ai->data;
+    struct account_data_header *hdr = data;
+
+    account_data_index(data, ai->data_len);
 
     uint32_t chunk_offset = offset - sizeof(struct chunk);
 
@@ -440,10 +707,14 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
                     next->offset_next = 0;
                     next->allocated = false;
                     next->length = 0;
+
+                    hdr->heap_tail = new_next_offset;
                 }
                 else
                 {
                     // merge with next chunk
+                    free_list_remove(data, chunk->offset_next);
+
                     chunk->offset_next = new_next_offset;
                     uint32_t offset_next_next = next->offset_next;
 
@@ -453,6 +724,8 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
                     next->allocated = false;
                     next->length = offset_next_next - new_next_offset - sizeof(struct chunk);
 
+                    free_list_insert(data, new_next_offset);
+
                     next = data + offset_next_next;
                     next->offset_prev = new_next_offset;
                 }
@@ -469,6 +742,8 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
                 next->allocated = false;
                 next->length = offset_next_next - new_next_offset - sizeof(struct chunk);
 
+                free_list_insert(data, new_next_offset);
+
                 next = data + offset_next_next;
                 next->offset_prev = new_next_offset;
             }
@@ -489,6 +764,8 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
 
             if (size < merged_size)
             {
+                free_list_remove(data, chunk->offset_next);
+
                 if (merged_size - alloc_size < 8 + sizeof(struct chunk))
                 {
                     // merge the two chunks
@@ -512,6 +789,8 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
                     next->length = offset_next_next - offset_next - sizeof(struct chunk);
                     next->allocated = false;
 
+                    free_list_insert(data, offset_next);
+
                     next = data + offset_next_next;
                     next->offset_prev = offset_next;
                 }
@@ -534,12 +813,67 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
                 next->allocated = false;
                 next->length = 0;
 
+                hdr->heap_tail = chunk->offset_next;
+
                 *res = offset;
                 return 0;
             }
         }
     }
 
+    // 3. Can we grow down into the previous chunk, and the next chunk if that is free too. This
+    // means a copy, but it does not leave a hole behind.
+    if (chunk->offset_prev && !((struct chunk *)(data + chunk->offset_prev))->allocated)
+    {
+        uint32_t prev_offset = chunk->offset_prev;
+        struct chunk *prev = data + prev_offset;
+        bool next_free = !next->allocated && next->offset_next;
+        uint32_t end = next_free ? next->offset_next : chunk->offset_next;
+        uint32_t merged_size = end - prev_offset - sizeof(struct chunk);
+
+        if (alloc_size <= merged_size)
+        {
+            uint32_t old_length = chunk->length;
+
+            free_list_remove(data, prev_offset);
+
+            if (next_free)
+                free_list_remove(data, chunk->offset_next);
+
+            move_down(data + prev_offset + sizeof(struct chunk), data + offset, old_length);
+
+            prev->allocated = true;
+            prev->length = size;
+
+            next = data + end;
+
+            if (merged_size - alloc_size < 8 + sizeof(struct chunk))
+            {
+                prev->offset_next = end;
+                next->offset_prev = prev_offset;
+            }
+            else
+            {
+                uint32_t split = prev_offset + sizeof(struct chunk) + alloc_size;
+
+                prev->offset_next = split;
+
+                struct chunk *rest = data + split;
+                rest->offset_prev = prev_offset;
+                rest->offset_next = end;
+                rest->length = end - split - sizeof(struct chunk);
+                rest->allocated = false;
+
+                free_list_insert(data, split);
+
+                next->offset_prev = split;
+            }
+
+            *res = prev_offset + sizeof(struct chunk);
+            return 0;
+        }
+    }
+
     uint32_t old_length = account_data_len(data, offset);
     uint32_t new_offset;
     uint64_t rc = account_data_alloc(ai, size, &new_offset);
@@ -547,13 +881,13 @@ uint64_t account_data_realloc(SolAccountInfo *ai, uint32_t offset, uint32_t size
         return rc;
 
     __memcpy(data + new_offset, data + offset, old_length);
-    account_data_free(data, offset);
+    account_data_free(ai, offset);
 
     *res = new_offset;
     return 0;
 }
 
-#ifdef TEST
+#if defined(TEST) && !defined(BENCH)
 // To run the test:
 // clang -DTEST -DSOL_TEST -O3 -Wall solana.c stdlib.c -o test && ./test
 #include <assert.h>
@@ -567,6 +901,7 @@ void validate_heap(void *data, uint32_t offs[100], uint32_t lens[100])
     uint32_t offset = hdr->heap_offset;
 
     uint32_t last_offset = 0;
+    uint32_t free_chunks = 0;
 
     for (;;)
     {
@@ -577,6 +912,25 @@ void validate_heap(void *data, uint32_t offs[100], uint32_t lens[100])
         {
             assert(chk->length == 0 && chk->offset_next == 0 && chk->offset_prev == last_offset);
             // printf("last object at 0x%08x\n", offset);
+
+            // the free list is either not built yet, or has exactly the free chunks
+            if (hdr->heap_tail)
+            {
+                assert(hdr->heap_tail == offset);
+
+                uint32_t prev = 0;
+
+                for (uint32_t f = hdr->free_list; f; f = links(data, f)->next)
+                {
+                    struct chunk *chk = data + f;
+                    assert(!chk->allocated && chk->offset_next);
+                    assert(links(data, f)->prev == prev);
+                    prev = f;
+                    free_chunks--;
+                }
+
+                assert(free_chunks == 0);
+            }
             return;
         }
 
@@ -609,6 +963,8 @@ void validate_heap(void *data, uint32_t offs[100], uint32_t lens[100])
         }
         else
         {
+            free_chunks++;
+
             // make sure we do not have this in our allocated list
             uint32_t off = offset + sizeof(struct chunk);
             for (int i = 0; i < 100; i++)
@@ -649,6 +1005,18 @@ int main()
     {
         validate_heap(data, offs, lens);
 
+        // accounts written by older versions have no free list, or return data in its place
+        if (rand() % 1000 == 0)
+        {
+            hdr->free_list = 0;
+            hdr->heap_tail = 0;
+        }
+        else if (rand() % 1000 == 0)
+        {
+            hdr->free_list = rand();
+            hdr->heap_tail = rand() % 2 ? rand() * 2654435761u : rand() % sizeof(data);
+        }
+
         int n = rand() % 100;
         if (offs[n] == 0)
         {
@@ -662,7 +1030,7 @@ int main()
         else if (rand() % 2)
         {
             // printf("STEP: free %d (0x%x)\n", n, offs[n]);
-            account_data_free(ai.data, offs[n]);
+            account_data_free(&ai, offs[n]);
             offs[n] = 0;
         }
         else
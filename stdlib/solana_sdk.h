@@ -186,6 +186,11 @@ static size_t sol_strlen(const char *s)
 void sol_panic_(const char *, uint64_t, uint64_t, uint64_t);
 #define sol_panic() sol_panic_(__FILE__, sizeof(__FILE__), __LINE__, 0)
 
+/**
+ * Copies the Clock sysvar to ret, which must be 40 bytes. Returns non-zero on failure
+ */
+uint64_t sol_get_clock_sysvar(void *ret);
+
 /**
  * Asserts
  */
@@ -209,14 +214,15 @@ typedef struct
  */
 typedef struct
 {
-    SolAccountInfo ka[10]; /** Pointer to an array of SolAccountInfo, must already
-                          point to an array of SolAccountInfos */
-    uint64_t ka_num;       /** Number of SolAccountInfo entries in `ka` */
-    const uint8_t *input;  /** pointer to the instruction data */
-    uint64_t input_len;    /** Length in bytes of the instruction data */
-    SolPubkey *program_id; /** program_id of the currently executing program */
-    const SolAccountInfo *ka_clock;
-    const SolAccountInfo *ka_instructions;
+    SolAccountInfo ka[10];                    /** Pointer to an array of SolAccountInfo, must already
+                                                 point to an array of SolAccountInfos */
+    uint64_t ka_num;                          /** Number of SolAccountInfo entries in `ka` */
+    const uint8_t *input;                     /** pointer to the instruction data */
+    uint64_t input_len;                       /** Length in bytes of the instruction data */
+    SolPubkey *program_id;                    /** program_id of the currently executing program */
+    struct clock_layout *clock;               /** Clock sysvar, read on first use */
+    const SolAccountInfo *ka_instructions;    /** Instructions sysvar account, found on first use */
+    struct ed25519_index *ed25519_signatures; /** Signatures checked by ed25519 instructions, indexed on first use */
 } SolParameters;
 
 /**
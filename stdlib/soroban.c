@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
-// Minimal WASM bump allocator in C (no free).
+// Minimal WASM bump allocator in C. By default nothing is freed, but the most
+// recent allocation can grow or shrink in place. Build with -DSOROBAN_FREE_LIST
+// to also reuse blocks which are freed or left behind by realloc.
 // Exports:
 //   soroban_alloc(size)                -> void*
 //   soroban_alloc_align(size, align)   -> void*
@@ -10,7 +12,8 @@
 //   soroban_malloc(size)               -> void*
 //   soroban_realloc(ptr, new_size)     -> void*   (COPY using header)
 //   soroban_realloc_with_old(ptr, old_size, new_size) -> void* (explicit copy)
-//   soroban_free(ptr, size, align)     -> void    (no-op)
+//   soroban_free(ptr, size, align)     -> void    (no-op without SOROBAN_FREE_LIST)
+//   soroban_heap_profile()             -> struct heap_profile* (only with HEAP_PROFILE)
 
 #include <stdint.h>
 #include <stddef.h>
@@ -20,6 +23,10 @@
 #define SOROBAN_PAGE_LOG2 16u // 64 KiB
 #endif
 #define SOROBAN_PAGE_SIZE (1u << SOROBAN_PAGE_LOG2)
+// Memory grows geometrically, by at least this many pages at a time
+#ifndef SOROBAN_GROW_MIN_PAGES
+#define SOROBAN_GROW_MIN_PAGES 1u
+#endif
 #define SOROBAN_MEM_INDEX 0 // wasm memory #0
 
 // clang/LLVM wasm32 intrinsics
@@ -32,6 +39,7 @@ static inline int32_t wasm_memory_grow_pages(uint32_t delta_pages)
     return (int32_t)__builtin_wasm_memory_grow(SOROBAN_MEM_INDEX, (int)delta_pages);
 }
 
+static uint32_t g_base = 0;   // memory end before the first allocation (bytes)
 static uint32_t g_cursor = 0; // current bump (bytes)
 static uint32_t g_limit = 0;  // grown end (bytes)
 
@@ -43,6 +51,40 @@ typedef struct
     uint32_t size; // payload size in bytes (not including this header)
 } soroban_hdr_t;
 
+#ifdef HEAP_PROFILE
+// Allocation statistics, see struct heap_profile in stdlib.h. Blocks which realloc
+// leaves behind without SOROBAN_FREE_LIST are never freed, so they stay in_use.
+static struct heap_profile g_profile;
+
+static inline void profile_alloc(uint32_t bytes, uint32_t capacity)
+{
+    g_profile.allocs++;
+    g_profile.bytes += bytes;
+    g_profile.in_use += capacity;
+    if (g_profile.in_use > g_profile.peak)
+        g_profile.peak = g_profile.in_use;
+}
+
+static inline void profile_resize(uint32_t old_size, uint32_t new_size)
+{
+    g_profile.in_use += new_size - old_size;
+    if (g_profile.in_use > g_profile.peak)
+        g_profile.peak = g_profile.in_use;
+}
+
+static inline void profile_walk(uint32_t walked)
+{
+    g_profile.walked += walked;
+    if (walked > g_profile.max_walk)
+        g_profile.max_walk = walked;
+}
+
+__attribute__((export_name("soroban_heap_profile"))) struct heap_profile *soroban_heap_profile(void)
+{
+    return &g_profile;
+}
+#endif
+
 static inline void *hdr_to_ptr(soroban_hdr_t *h)
 {
     return (void *)((uintptr_t)h + sizeof(soroban_hdr_t));
@@ -75,27 +117,116 @@ static inline void maybe_init(void)
     if (g_limit == 0)
     {
         uint32_t end = wasm_memory_size_pages() << SOROBAN_PAGE_LOG2; // bytes
+        g_base = end;
         g_cursor = end;
         g_limit = end;
     }
 }
 
 // grow so that `need_bytes` fits (<== need_bytes is a byte address)
+// Each grow is a metered host call, so grow by at least as much as the heap has grown so
+// far. If that much memory is not available, grow by exactly what is needed.
 static inline int ensure_capacity(uint32_t need_bytes)
 {
     if (need_bytes <= g_limit)
         return 1;
     uint32_t deficit = need_bytes - g_limit;
     uint32_t pages = (deficit + (SOROBAN_PAGE_SIZE - 1)) >> SOROBAN_PAGE_LOG2;
-    if (wasm_memory_grow_pages(pages) < 0)
+    uint32_t step = (g_limit - g_base) >> SOROBAN_PAGE_LOG2;
+    if (step < SOROBAN_GROW_MIN_PAGES)
+        step = SOROBAN_GROW_MIN_PAGES;
+    if (step > pages && wasm_memory_grow_pages(step) >= 0)
+        pages = step;
+    else if (wasm_memory_grow_pages(pages) < 0)
         return 0; // OOM
     g_limit += pages << SOROBAN_PAGE_LOG2;
     return 1;
 }
 
+#ifdef SOROBAN_FREE_LIST
+// Freed blocks are kept on singly linked lists by size class: list n holds blocks
+// of at least 2^n and less than 2^(n+1) bytes. The link is stored in the block
+// itself, so blocks smaller than a pointer are never reused. The header size of a
+// reused block stays at its full capacity.
+static void *g_free[32];
+
+static inline uint32_t size_class(uint32_t bytes)
+{
+    return 31 - __builtin_clz(bytes);
+}
+
+static void *free_list_take(uint32_t bytes)
+{
+    if (bytes < sizeof(void *))
+        bytes = sizeof(void *);
+
+    // the first class where every block is big enough
+    uint32_t first = size_class(bytes - 1) + 1, c;
+    void *p = (void *)0;
+
+    for (c = first; c < 32; c++)
+    {
+        p = g_free[c];
+
+        if (p)
+        {
+            g_free[c] = *(void **)p;
+            break;
+        }
+    }
+
+#ifdef HEAP_PROFILE
+    profile_walk(c - first + (p != (void *)0));
+#endif
+
+    return p;
+}
+
+static void free_block(void *ptr)
+{
+    soroban_hdr_t *hdr = ptr_to_hdr(ptr);
+
+#ifdef HEAP_PROFILE
+    g_profile.frees++;
+    g_profile.in_use -= hdr->size;
+#endif
+
+    if ((uint32_t)(uintptr_t)ptr + hdr->size == g_cursor)
+    {
+        // the most recent allocation; just pop it
+        g_cursor = (uint32_t)(uintptr_t)hdr;
+    }
+    else if (hdr->size >= sizeof(void *))
+    {
+        uint32_t c = size_class(hdr->size);
+
+        *(void **)ptr = g_free[c];
+        g_free[c] = ptr;
+    }
+}
+#endif
+
 static void *alloc_impl(uint32_t bytes, uint32_t align)
 {
     maybe_init();
+
+#ifdef SOROBAN_FREE_LIST
+    // reused blocks are only 8 byte aligned
+    if (align <= 8)
+    {
+        void *p = free_list_take(bytes);
+
+        if (p)
+        {
+#ifdef HEAP_PROFILE
+            // a reused block keeps its full capacity
+            profile_alloc(bytes, ptr_to_hdr(p)->size);
+#endif
+            return p;
+        }
+    }
+#endif
+
     // Ensure there is space for the header while keeping the returned pointer
     // aligned as requested.
     uint32_t start = align_up(g_cursor + (uint32_t)sizeof(soroban_hdr_t), align ? align : 1);
@@ -113,6 +244,9 @@ static void *alloc_impl(uint32_t bytes, uint32_t align)
     // Write header just before the returned pointer
     soroban_hdr_t *hdr = (soroban_hdr_t *)(uintptr_t)(start - (uint32_t)sizeof(soroban_hdr_t));
     hdr->size = bytes;
+#ifdef HEAP_PROFILE
+    profile_alloc(bytes, bytes);
+#endif
     return (void *)(uintptr_t)start;
 }
 
@@ -175,16 +309,36 @@ __attribute__((export_name("soroban_malloc"))) void *soroban_malloc(uint32_t siz
 // Reallocate and copy previous contents. Since we store a small header in
 // front of each allocation, we can determine the old size here and copy the
 // minimum of old and new sizes.
-__attribute__((export_name("soroban_realloc"))) void *soroban_realloc(void *old_ptr, uint32_t new_size)
+// If the allocation at ptr is the most recent one, it ends at g_cursor and can be
+// resized without copying. Returns 0 if it is not, or if memory cannot grow.
+static int resize_in_place(void *ptr, uint32_t new_size)
 {
-    if (old_ptr == (void *)0)
-    {
-        return alloc_impl(new_size, 8);
-    }
+    soroban_hdr_t *hdr = ptr_to_hdr(ptr);
+    uint32_t start = (uint32_t)(uintptr_t)ptr;
 
-    // Determine old size from the header placed before the allocation
-    soroban_hdr_t *old_hdr = ptr_to_hdr(old_ptr);
-    uint32_t old_size = old_hdr->size;
+    if (start + hdr->size != g_cursor)
+        return 0;
+
+    if (!ensure_capacity(start + new_size))
+        return 0;
+
+    g_cursor = start + new_size;
+#ifdef HEAP_PROFILE
+    profile_resize(hdr->size, new_size);
+#endif
+    hdr->size = new_size;
+
+    return 1;
+}
+
+// Move an allocation which could not be resized in place
+static void *realloc_move(void *old_ptr, uint32_t old_size, uint32_t new_size)
+{
+#ifdef SOROBAN_FREE_LIST
+    // a block which is already big enough can be kept
+    if (new_size <= ptr_to_hdr(old_ptr)->size)
+        return old_ptr;
+#endif
 
     void *new_ptr = alloc_impl(new_size, 8);
     if (new_ptr == (void *)0)
@@ -193,9 +347,34 @@ __attribute__((export_name("soroban_realloc"))) void *soroban_realloc(void *old_
     uint32_t copy = old_size < new_size ? old_size : new_size;
     if (copy)
         mem_copy(new_ptr, old_ptr, copy);
+
+#ifdef SOROBAN_FREE_LIST
+    free_block(old_ptr);
+#endif
+
     return new_ptr;
 }
 
+__attribute__((export_name("soroban_realloc"))) void *soroban_realloc(void *old_ptr, uint32_t new_size)
+{
+#ifdef HEAP_PROFILE
+    g_profile.reallocs++;
+#endif
+
+    if (old_ptr == (void *)0)
+    {
+        return alloc_impl(new_size, 8);
+    }
+
+    if (resize_in_place(old_ptr, new_size))
+        return old_ptr;
+
+    // Determine old size from the header placed before the allocation
+    soroban_hdr_t *old_hdr = ptr_to_hdr(old_ptr);
+
+    return realloc_move(old_ptr, old_hdr->size, new_size);
+}
+
 // Variant that accepts the old size explicitly. Useful when the caller
 // already knows the previous allocation size and wants to avoid relying on
 // the header (or for interop with older allocations).
@@ -203,22 +382,29 @@ __attribute__((export_name("soroban_realloc_with_old"))) void *soroban_realloc_w
                                                                                         uint32_t old_size,
                                                                                         uint32_t new_size)
 {
+#ifdef HEAP_PROFILE
+    g_profile.reallocs++;
+#endif
+
     if (old_ptr == (void *)0)
     {
         return alloc_impl(new_size, 8);
     }
-    void *new_ptr = alloc_impl(new_size, 8);
-    if (new_ptr == (void *)0)
-        return (void *)0; // OOM
-    uint32_t copy = old_size < new_size ? old_size : new_size;
-    if (copy)
-        mem_copy(new_ptr, old_ptr, copy);
-    return new_ptr;
+
+    if (resize_in_place(old_ptr, new_size))
+        return old_ptr;
+
+    return realloc_move(old_ptr, old_size, new_size);
 }
 
 __attribute__((export_name("soroban_free"))) void soroban_free(void *_ptr, uint32_t _size, uint32_t _align)
 {
-    (void)_ptr;
     (void)_size;
-    (void)_align; // bump allocator: no-op
+    (void)_align;
+#ifdef SOROBAN_FREE_LIST
+    if (_ptr != (void *)0)
+        free_block(_ptr);
+#else
+    (void)_ptr; // bump allocator: no-op
+#endif
 }
@@ -7,25 +7,61 @@
 #include "stdlib.h"
 
 /*
+ * The memory primitives below work on 8 bytes at a time once the pointers are
+ * aligned, with a byte loop for the unaligned head and the tail. If the wasm
+ * stdlib is built with WASM_STDLIB_FLAGS=-mbulk-memory, the
+ * memory.copy and memory.fill instructions are used instead.
  */
+#define WORD_ALIGNED(p) (((uintptr_t)(p) & 7) == 0)
+#define BYTES_TO_WORD(b) ((uint64_t)(b) * 0x0101010101010101ull)
+
 void __memset8(void *_dest, uint64_t val, uint32_t length)
 {
     uint64_t *dest = _dest;
 
-    do
+    while (length--)
     {
         *dest++ = val;
-    } while (--length);
+    }
 }
 
 void __memset(void *_dest, uint8_t val, size_t length)
 {
+#ifdef __wasm_bulk_memory__
+    __builtin_memset(_dest, val, length);
+#else
     uint8_t *dest = _dest;
 
-    do
+    while (length && !WORD_ALIGNED(dest))
     {
         *dest++ = val;
-    } while (--length);
+        length--;
+    }
+
+    uint64_t *dest64 = (uint64_t *)dest;
+    uint64_t val64 = BYTES_TO_WORD(val);
+
+    for (; length >= 32; length -= 32)
+    {
+        dest64[0] = val64;
+        dest64[1] = val64;
+        dest64[2] = val64;
+        dest64[3] = val64;
+        dest64 += 4;
+    }
+
+    for (; length >= 8; length -= 8)
+    {
+        *dest64++ = val64;
+    }
+
+    dest = (uint8_t *)dest64;
+
+    while (length--)
+    {
+        *dest++ = val;
+    }
+#endif
 }
 
 /*
@@ -37,10 +73,10 @@ void __memcpy8(void *_dest, void *_src, uint32_t length)
     uint64_t *dest = _dest;
     uint64_t *src = _src;
 
-    do
+    while (length--)
     {
         *dest++ = *src++;
-    } while (--length);
+    }
 }
 
 void *__memcpy(void *_dest, const void *_src, uint32_t length)
@@ -48,12 +84,49 @@ void *__memcpy(void *_dest, const void *_src, uint32_t length)
     uint8_t *dest = _dest;
     const uint8_t *src = _src;
 
+#ifdef __wasm_bulk_memory__
+    __builtin_memcpy(dest, src, length);
+
+    return dest + length;
+#else
+    // words can only be copied if both pointers have the same alignment
+    if (WORD_ALIGNED((uintptr_t)dest ^ (uintptr_t)src))
+    {
+        while (length && !WORD_ALIGNED(dest))
+        {
+            *dest++ = *src++;
+            length--;
+        }
+
+        uint64_t *dest64 = (uint64_t *)dest;
+        const uint64_t *src64 = (const uint64_t *)src;
+
+        for (; length >= 32; length -= 32)
+        {
+            dest64[0] = src64[0];
+            dest64[1] = src64[1];
+            dest64[2] = src64[2];
+            dest64[3] = src64[3];
+            dest64 += 4;
+            src64 += 4;
+        }
+
+        for (; length >= 8; length -= 8)
+        {
+            *dest64++ = *src64++;
+        }
+
+        dest = (uint8_t *)dest64;
+        src = (const uint8_t *)src64;
+    }
+
     while (length--)
     {
         *dest++ = *src++;
     }
 
     return dest;
+#endif
 }
 
 /*
@@ -69,19 +142,63 @@ void __bzero8(void *_dest, uint32_t length)
     }
 }
 
+// Compare big endian words; the first word that differs decides the order
+static inline int memcmp_words(const uint64_t *a, const uint64_t *b, uint32_t words)
+{
+    for (uint32_t i = 0; i < words; i++)
+    {
+        if (a[i] != b[i])
+            return __builtin_bswap64(a[i]) < __builtin_bswap64(b[i]) ? -1 : 1;
+    }
+
+    return 0;
+}
+
 int __memcmp_ord(uint8_t *a, uint8_t *b, uint32_t len)
 {
-    do
+    // words can only be compared if both pointers have the same alignment
+    if (WORD_ALIGNED((uintptr_t)a ^ (uintptr_t)b))
+    {
+        while (len && !WORD_ALIGNED(a))
+        {
+            int diff = (int)(*a++) - (int)(*b++);
+
+            if (diff)
+                return diff;
+
+            len--;
+        }
+
+        int res = memcmp_words((const uint64_t *)a, (const uint64_t *)b, len / 8);
+
+        if (res)
+            return res;
+
+        a += len & ~7;
+        b += len & ~7;
+        len &= 7;
+    }
+
+    while (len--)
     {
         int diff = (int)(*a++) - (int)(*b++);
 
         if (diff)
             return diff;
-    } while (--len);
+    }
 
     return 0;
 }
 
+// Fixed width version of __memcmp_ord for 32 byte addresses, used by codegen
+int __memcmp_ord32(uint8_t *a, uint8_t *b)
+{
+    if (WORD_ALIGNED((uintptr_t)a | (uintptr_t)b))
+        return memcmp_words((const uint64_t *)a, (const uint64_t *)b, 4);
+
+    return __memcmp_ord(a, b, 32);
+}
+
 // This function is used for abi decoding integers.
 // ABI encoding is big endian, and can have integers of 8 to 256 bits
 // (1 to 32 bytes). This function copies length bytes and reverses the
@@ -127,18 +244,105 @@ void __leNtobeN(uint8_t *from, uint8_t *to, uint32_t length)
     } while (--length);
 }
 
-uint64_t vector_hash(struct vector *v)
+/*
+ * Fixed width versions of __beNtoleN for addresses (20 bytes), 256 bit integers and hashes
+ * (32 bytes) and 512 bit integers (64 bytes). Codegen uses these when the length is one of
+ * these sizes. When both pointers are aligned, whole words are swapped at once.
+ */
+static inline void bswap_words(const uint64_t *from, uint64_t *to, uint32_t words)
 {
-    uint64_t hash = 0;
-    uint8_t *data = v->data;
-    uint32_t len = v->len;
+    for (uint32_t i = 0; i < words; i++)
+    {
+        to[i] = __builtin_bswap64(from[words - 1 - i]);
+    }
+}
 
-    while (len--)
+void __bswap_bytes20(uint8_t *from, uint8_t *to)
+{
+    // 20 bytes is not a whole number of 8 byte words, so use 4 byte words
+    if ((((uintptr_t)from | (uintptr_t)to) & 3) == 0)
+    {
+        const uint32_t *from32 = (const uint32_t *)from;
+        uint32_t *to32 = (uint32_t *)to;
+
+        for (uint32_t i = 0; i < 5; i++)
+        {
+            to32[i] = __builtin_bswap32(from32[4 - i]);
+        }
+    }
+    else
     {
-        hash += *data;
+        __beNtoleN(from, to, 20);
     }
+}
 
-    return hash;
+void __bswap_bytes32(uint8_t *from, uint8_t *to)
+{
+    if (WORD_ALIGNED((uintptr_t)from | (uintptr_t)to))
+        bswap_words((const uint64_t *)from, (uint64_t *)to, 4);
+    else
+        __beNtoleN(from, to, 32);
+}
+
+void __bswap_bytes64(uint8_t *from, uint8_t *to)
+{
+    if (WORD_ALIGNED((uintptr_t)from | (uintptr_t)to))
+        bswap_words((const uint64_t *)from, (uint64_t *)to, 8);
+    else
+        __beNtoleN(from, to, 64);
+}
+
+// Non-cryptographic hash of arbitrary bytes, 8 bytes per step
+uint64_t __hash_bytes(const uint8_t *data, uint32_t length)
+{
+    uint64_t hash = hash_mix(0, length);
+
+    if (WORD_ALIGNED(data))
+    {
+        const uint64_t *data64 = (const uint64_t *)data;
+
+        for (; length >= 8; length -= 8)
+        {
+            hash = hash_mix(hash, *data64++);
+        }
+
+        data = (const uint8_t *)data64;
+    }
+    else
+    {
+        for (; length >= 8; length -= 8)
+        {
+            uint64_t word = 0;
+
+            for (int i = 0; i < 8; i++)
+                word |= (uint64_t)data[i] << (i * 8);
+
+            hash = hash_mix(hash, word);
+            data += 8;
+        }
+    }
+
+    if (length)
+    {
+        uint64_t word = 0;
+
+        for (uint32_t i = 0; i < length; i++)
+            word |= (uint64_t)data[i] << (i * 8);
+
+        hash = hash_mix(hash, word);
+    }
+
+    return hash_finish(hash);
+}
+
+// This selects the bucket of storage mappings keyed by bytes or string, so it must return the
+// same value as older versions did. Those added the first byte once for every byte of the key.
+uint64_t vector_hash(struct vector *v)
+{
+    if (!v->len)
+        return 0;
+
+    return (uint64_t)v->len * v->data[0];
 }
 
 bool __memcmp(uint8_t *left, uint32_t left_len, uint8_t *right, uint32_t right_len)
@@ -146,6 +350,28 @@ bool __memcmp(uint8_t *left, uint32_t left_len, uint8_t *right, uint32_t right_l
     if (left_len != right_len)
         return false;
 
+    if (WORD_ALIGNED((uintptr_t)left ^ (uintptr_t)right))
+    {
+        while (left_len && !WORD_ALIGNED(left))
+        {
+            if (*left++ != *right++)
+                return false;
+            left_len--;
+        }
+
+        uint64_t *left64 = (uint64_t *)left;
+        uint64_t *right64 = (uint64_t *)right;
+
+        for (; left_len >= 8; left_len -= 8)
+        {
+            if (*left64++ != *right64++)
+                return false;
+        }
+
+        left = (uint8_t *)left64;
+        right = (uint8_t *)right64;
+    }
+
     while (left_len--)
     {
         if (*left++ != *right++)
@@ -177,17 +403,11 @@ struct vector *vector_new(uint32_t members, uint32_t size, uint8_t *initial)
 
     if (initial != VECTOR_EMPTY)
     {
-        while (size_array--)
-        {
-            *data++ = *initial++;
-        }
+        __memcpy(data, initial, size_array);
     }
     else
     {
-        while (size_array--)
-        {
-            *data++ = 0;
-        }
+        __memset(data, 0, size_array);
     }
 
     return v;
@@ -14,3 +14,42 @@ extern void *__malloc(uint32_t size);
 extern void __memset(void *dest, uint8_t val, size_t length);
 extern void *__memcpy(void *dest, const void *src, uint32_t length);
 extern void __memcpy8(void *_dest, void *_src, uint32_t length);
+
+#ifdef HEAP_PROFILE
+/*
+ * Allocation statistics, kept by heap.c and soroban.c when the stdlib is built with -DHEAP_PROFILE
+ */
+struct heap_profile
+{
+    uint32_t allocs;   // number of allocations
+    uint32_t frees;    // number of frees
+    uint32_t reallocs; // number of reallocations, including those which moved the data
+    uint32_t bytes;    // total number of bytes requested by allocations
+    uint32_t in_use;   // bytes allocated right now
+    uint32_t peak;     // the largest in_use has been
+    uint32_t walked;   // total number of chunks visited while looking for free space
+    uint32_t max_walk; // the most chunks visited by a single allocation
+};
+
+extern void __heap_report();
+#endif
+
+/*
+ * FxHash style mixing step, used for hashing in-memory index keys one 64 bit word at a time.
+ * The buckets of storage mappings are chosen by vector_hash and address_hash, which must not
+ * change.
+ */
+#define HASH_SEED 0x517cc1b727220a95ull
+
+static inline uint64_t hash_mix(uint64_t hash, uint64_t word)
+{
+    return (((hash << 5) | (hash >> 59)) ^ word) * HASH_SEED;
+}
+
+// The hash is reduced modulo a small prime, so fold the high bits into the low ones
+static inline uint64_t hash_finish(uint64_t hash)
+{
+    return hash ^ (hash >> 32);
+}
+
+extern uint64_t __hash_bytes(const uint8_t *data, uint32_t length);
@@ -129,3 +129,43 @@ fn basic_compilation_from_toml() {
 
     compile_cmd.current_dir(polkadot_test).assert().success();
 }
+
+#[test]
+fn compile_with_cache() {
+    let tmp = TempDir::new_in("tests").unwrap();
+
+    let cache = tmp.path().join("cache");
+
+    let compile = |output: &str| {
+        cargo_bin_cmd!("solang")
+            .args([
+                "compile",
+                "examples/solana/flipper.sol",
+                "--target",
+                "solana",
+                "--verbose",
+                "--jobs",
+                "2",
+                "--cache-dir",
+            ])
+            .arg(cache.clone())
+            .arg("--output")
+            .arg(tmp.path().join(output))
+            .assert()
+            .success()
+            .get_output()
+            .stderr
+            .clone()
+    };
+
+    let stderr = String::from_utf8_lossy(&compile("first")).to_string();
+    assert!(!stderr.contains("Using cached binary"));
+
+    let stderr = String::from_utf8_lossy(&compile("second")).to_string();
+    assert!(stderr.contains("info: Using cached binary for contract flipper"));
+
+    assert_eq!(
+        std::fs::read(tmp.path().join("first/flipper.so")).unwrap(),
+        std::fs::read(tmp.path().join("second/flipper.so")).unwrap()
+    );
+}
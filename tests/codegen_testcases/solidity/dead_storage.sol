@@ -12,7 +12,8 @@ contract deadstorage {
     // CHECK: load storage slot(uint256 0) ty:int256
     // NOT-CHECK: load storage slot(uint256 0) ty:int256
 
-    // Two references to "a" with a write to A in between must result in two loadstorage
+    // Two references to "a" with a write to A in between. The second reference uses the value
+    // which was stored, so a single loadstorage remains
     // BEGIN-CHECK: deadstorage::function::test2
     function test2() public returns (int) {
         int x = a;
@@ -22,7 +23,8 @@ contract deadstorage {
     }
 
     // CHECK: load storage slot(uint256 0) ty:int256
-    // CHECK: load storage slot(uint256 0) ty:int256
+    // CHECK: store storage slot(uint256 0)
+    // NOT-CHECK: load storage slot(uint256 0) ty:int256
 
     // make sure that reachable stores are not eliminated
     // BEGIN-CHECK: deadstorage::function::test3
@@ -68,7 +70,7 @@ contract deadstorage {
     // NOT-CHECK: store storage slot(uint256 2)
 
     // BEGIN-CHECK: deadstorage::function::test6
-    // store/load are not merged yet. Make sure that we have a store before a load
+    // the loads use the stored values, which makes the first store redundant
     int test6var;
 
     function test6() public returns (int) {
@@ -79,7 +81,8 @@ contract deadstorage {
     }
 
     // CHECK: store storage slot(uint256 3)
-    // CHECK: store storage slot(uint256 3)
+    // NOT-CHECK: store storage slot(uint256 3)
+    // NOT-CHECK: load storage slot(uint256 3)
 
     // BEGIN-CHECK: deadstorage::function::test7
     // storage should be flushed before function call
@@ -167,6 +170,20 @@ contract deadstorage {
     }
     // CHECK: load storage slot((overflowing uint256 19
     // NOT-CHECK: load storage slot((overflowing uint256 19
+
+    // BEGIN-CHECK: deadstorage::function::test13
+    // the store is not done on every path to the load, so the load must stay
+    int test13var;
+
+    function test13(bool c) public returns (int) {
+        if (c) {
+            test13var = 1;
+        }
+        return test13var;
+    }
+
+    // CHECK: store storage slot(uint256 30)
+    // CHECK: load storage slot(uint256 30)
 }
 
 contract foo {
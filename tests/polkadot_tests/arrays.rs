@@ -850,6 +850,64 @@ fn dynamic_array_push() {
     runtime.function("test", Vec::new());
 }
 
+#[test]
+fn dynamic_array_push_pop_capacity() {
+    // scale encoding: the compact length of 172 takes two bytes
+    let mut runtime = build_solidity(
+        r#"
+        contract foo {
+            uint32[] stored;
+            bytes storedBytes;
+
+            function test() public returns (uint32[] memory, bytes memory) {
+                uint32[] memory bar = new uint32[](0);
+                bytes memory baz = new bytes(0);
+
+                // push past several doublings of the capacity, popping now and then
+                for (uint32 i = 0; i < 200; i++) {
+                    bar.push(i);
+                    baz.push(bytes1(uint8(i)));
+
+                    if (i % 7 == 6) {
+                        bar.pop();
+                        baz.pop();
+                    }
+                }
+
+                assert(bar.length == 172);
+                assert(baz.length == 172);
+                assert(bar[171] == 199);
+
+                stored = bar;
+                storedBytes = baz;
+
+                assert(stored.length == 172);
+                assert(storedBytes.length == 172);
+                assert(stored[171] == 199);
+
+                // a vector loaded from storage can be grown too
+                uint32[] memory copy = stored;
+                copy.push(1000);
+                assert(copy.length == 173);
+                assert(copy[172] == 1000);
+                assert(stored.length == 172);
+
+                assert(abi.encode(bar).length == 690);
+
+                return (bar, baz);
+            }
+        }
+        "#,
+    );
+
+    runtime.function("test", Vec::new());
+
+    let values: Vec<u32> = (0..200).filter(|i| i % 7 != 6).collect();
+    let bytes: Vec<u8> = values.iter().map(|v| *v as u8).collect();
+
+    assert_eq!(runtime.output(), (values, bytes).encode());
+}
+
 #[test]
 fn dynamic_array_pop() {
     let mut runtime = build_solidity(
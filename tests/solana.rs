@@ -89,6 +89,7 @@ struct VirtualMachine {
     events: Vec<Vec<Vec<u8>>>,
     return_data: Option<(Account, Vec<u8>)>,
     call_params_check: HashMap<Pubkey, CallParametersCheck>,
+    heap_size: usize,
 }
 
 #[derive(Clone)]
@@ -246,6 +247,12 @@ impl VirtualMachineBuilder {
 
         let cur = programs.last().unwrap().clone();
 
+        let heap_size = self
+            .opts
+            .as_ref()
+            .and_then(|opts| opts.solana_heap_size)
+            .map_or(DEFAULT_HEAP_SIZE, |size| size as usize);
+
         VirtualMachine {
             account_data,
             programs,
@@ -254,6 +261,7 @@ impl VirtualMachineBuilder {
             events: Vec::new(),
             return_data: None,
             call_params_check: HashMap::new(),
+            heap_size,
         }
     }
 }
@@ -437,6 +445,7 @@ struct SyscallContext<'a> {
     input_len: usize,
     refs: Rc<RefCell<&'a mut Vec<AccountRef>>>,
     heap: *const u8,
+    heap_size: usize,
     pub remaining: u64,
 }
 
@@ -457,7 +466,7 @@ impl SyscallContext<'_> {
     pub fn heap_verify(&self) {
         const VERBOSE: bool = false;
 
-        let heap: &[u8] = unsafe { std::slice::from_raw_parts(self.heap, DEFAULT_HEAP_SIZE) };
+        let heap: &[u8] = unsafe { std::slice::from_raw_parts(self.heap, self.heap_size) };
 
         const HEAP_START: u64 = 0x3_0000_0000;
         let mut current_elem = HEAP_START;
@@ -888,6 +897,40 @@ fn sol_get_return_data(
     }
 }
 
+fn sol_get_clock_sysvar(
+    context: &mut SyscallContext,
+    addr: u64,
+    _arg2: u64,
+    _arg3: u64,
+    _arg4: u64,
+    _arg5: u64,
+    memory_mapping: &mut MemoryMapping,
+    result: &mut ProgramResult,
+) {
+    context.heap_verify();
+
+    if let Ok(vm) = context.vm.try_borrow() {
+        let clock_account: Account = "SysvarC1ock11111111111111111111111111111111"
+            .from_base58()
+            .unwrap()
+            .try_into()
+            .unwrap();
+
+        let clock = &vm.account_data[&clock_account].data;
+
+        let clock_result = question_mark!(
+            translate_slice_mut::<u8>(memory_mapping, addr, clock.len() as u64),
+            result
+        );
+
+        clock_result.copy_from_slice(clock);
+
+        *result = ProgramResult::Ok(0);
+    } else {
+        panic!();
+    }
+}
+
 fn sol_log_data(
     context: &mut SyscallContext,
     addr: u64,
@@ -1365,7 +1408,7 @@ impl VirtualMachine {
         println!("running bpf with calldata:{}", hex::encode(calldata));
 
         let (mut parameter_bytes, mut refs) = serialize_parameters(calldata, metas, self);
-        let mut heap = vec![0_u8; DEFAULT_HEAP_SIZE];
+        let mut heap = vec![0_u8; self.heap_size];
 
         let program = &self.stack[0];
         let config = Config {
@@ -1421,6 +1464,10 @@ impl VirtualMachine {
             .register_function(b"sol_log_data", sol_log_data)
             .unwrap();
 
+        loader
+            .register_function(b"sol_get_clock_sysvar", sol_get_clock_sysvar)
+            .unwrap();
+
         // program.program
         println!("program: {}", program.id.to_base58());
 
@@ -1440,6 +1487,7 @@ impl VirtualMachine {
             input_len: parameter_bytes.len(),
             refs: Rc::new(RefCell::new(&mut refs)),
             heap: heap.as_ptr(),
+            heap_size: heap.len(),
             remaining: 1000000,
         };
 
@@ -1463,7 +1511,11 @@ impl VirtualMachine {
             4196,
         );
 
-        let (_, res) = vm.execute_program(&verified_executable, true);
+        let (instruction_count, res) = vm.execute_program(&verified_executable, true);
+
+        if std::env::var_os("SOLANG_COMPUTE_UNITS").is_some() {
+            println!("compute units: {instruction_count}");
+        }
 
         deserialize_parameters(&parameter_bytes, &refs, &mut self.account_data);
 
@@ -1554,13 +1606,10 @@ impl VirtualMachine {
             }
 
             let mut prev_offset = 0;
-            let return_len = LittleEndian::read_u32(&data[4..]) as usize;
-            let return_offset = LittleEndian::read_u32(&data[8..]) as usize;
+            let free_list = LittleEndian::read_u32(&data[4..]) as usize;
+            let heap_tail = LittleEndian::read_u32(&data[8..]) as usize;
             let mut offset = LittleEndian::read_u32(&data[12..]) as usize;
-
-            // The return_offset/len fields are no longer used (we should remove them at some point)
-            assert_eq!(return_len, 0);
-            assert_eq!(return_offset, 0);
+            let mut free_chunks = Vec::new();
 
             println!(
                 "static: length:{:x} {}",
@@ -1599,9 +1648,37 @@ impl VirtualMachine {
                     assert_eq!(length, 0);
                     assert_eq!(allocate, 0);
 
+                    // The free index is built on first use, until then both are zero
+                    if heap_tail == 0 {
+                        assert_eq!(free_list, 0);
+                    } else {
+                        assert_eq!(heap_tail, offset);
+
+                        let mut listed = Vec::new();
+                        let mut prev_free = 0;
+                        let mut free = free_list;
+
+                        while free != 0 {
+                            assert_eq!(
+                                LittleEndian::read_u32(&data[free + 20..]) as usize,
+                                prev_free
+                            );
+                            listed.push(free);
+                            prev_free = free;
+                            free = LittleEndian::read_u32(&data[free + 16..]) as usize;
+                        }
+
+                        listed.sort_unstable();
+                        assert_eq!(listed, free_chunks);
+                    }
+
                     break;
                 }
 
+                if allocate == 0 {
+                    free_chunks.push(offset);
+                }
+
                 let space = next - offset - 16;
                 assert!(length <= space);
 
@@ -1838,6 +1838,88 @@ fn dynamic_array_push() {
     runtime.function("test").call();
 }
 
+#[test]
+fn dynamic_array_push_pop_capacity() {
+    // borsh encoding: a four byte length followed by the elements
+    let mut runtime = build_solidity(
+        r#"
+        contract foo {
+            uint32[] stored;
+            bytes storedBytes;
+
+            function test() public returns (uint32[] memory, bytes memory) {
+                uint32[] memory bar = new uint32[](0);
+                bytes memory baz = new bytes(0);
+
+                // push past several doublings of the capacity, popping now and then
+                for (uint32 i = 0; i < 200; i++) {
+                    bar.push(i);
+                    baz.push(bytes1(uint8(i)));
+
+                    if (i % 7 == 6) {
+                        bar.pop();
+                        baz.pop();
+                    }
+                }
+
+                assert(bar.length == 172);
+                assert(baz.length == 172);
+                assert(bar[171] == 199);
+
+                stored = bar;
+                storedBytes = baz;
+
+                assert(stored.length == 172);
+                assert(storedBytes.length == 172);
+                assert(stored[171] == 199);
+
+                // a vector loaded from storage can be grown too
+                uint32[] memory copy = stored;
+                copy.push(1000);
+                assert(copy.length == 173);
+                assert(copy[172] == 1000);
+                assert(stored.length == 172);
+
+                assert(abi.encode(bar).length == 692);
+
+                return (bar, baz);
+            }
+        }
+        "#,
+    );
+
+    let data_account = runtime.initialize_data_account();
+    runtime
+        .function("new")
+        .accounts(vec![("dataAccount", data_account)])
+        .call();
+
+    let returns = runtime
+        .function("test")
+        .accounts(vec![("dataAccount", data_account)])
+        .call()
+        .unwrap()
+        .unwrap_tuple();
+
+    let values: Vec<u32> = (0..200).filter(|i| i % 7 != 6).collect();
+
+    assert_eq!(
+        returns,
+        vec![
+            BorshToken::Array(
+                values
+                    .iter()
+                    .map(|v| BorshToken::Uint {
+                        width: 32,
+                        value: BigInt::from(*v),
+                    })
+                    .collect()
+            ),
+            BorshToken::Bytes(values.iter().map(|v| *v as u8).collect()),
+        ]
+    );
+}
+
 #[test]
 fn dynamic_array_pop() {
     let mut runtime = build_solidity(
@@ -10,9 +10,7 @@ use std::mem::size_of;
 
 #[derive(Serialize)]
 #[repr(C)]
-struct Instructions {
-    num_instructions: u16,
-    instruction_offset: u16,
+struct Instruction {
     num_accounts: u16,
     /* assume no accounts */
     program_id: [u8; 32],
@@ -22,15 +20,13 @@ struct Instructions {
 #[derive(Serialize)]
 #[repr(C)]
 pub struct Ed25519SignatureOffsets {
-    num_signatures: u8,
-    padding: u8,
-    signature_offset: u16,            // offset to ed25519 signature of 64 bytes
-    signature_instruction_index: u16, // instruction index to find signature
-    public_key_offset: u16,           // offset to public key of 32 bytes
+    signature_offset: u16,             // offset to ed25519 signature of 64 bytes
+    signature_instruction_index: u16,  // instruction index to find signature
+    public_key_offset: u16,            // offset to public key of 32 bytes
     public_key_instruction_index: u16, // instruction index to find public key
-    message_data_offset: u16,         // offset to start of message data
-    message_data_size: u16,           // size of message data
-    message_instruction_index: u16,   // index of instruction data to get message data
+    message_data_offset: u16,          // offset to start of message data
+    message_data_size: u16,            // size of message data
+    message_instruction_index: u16,    // index of instruction data to get message data
 }
 
 #[test]
@@ -154,41 +150,204 @@ fn verify() {
     assert_eq!(returns, BorshToken::Bool(false));
 }
 
-fn encode_instructions(public_key: &[u8], signature: &[u8], message: &[u8]) -> Vec<u8> {
-    let offsets = Ed25519SignatureOffsets {
-        num_signatures: 1,
-        padding: 0,
-        signature_offset: size_of::<Ed25519SignatureOffsets>() as u16,
-        signature_instruction_index: 0,
-        public_key_offset: (size_of::<Ed25519SignatureOffsets>() + signature.len()) as u16,
-        public_key_instruction_index: 0,
-        message_data_offset: (size_of::<Ed25519SignatureOffsets>()
-            + signature.len()
-            + public_key.len()) as u16,
-        message_instruction_index: 0,
-        message_data_size: message.len() as u16,
-    };
+#[test]
+fn verify_many() {
+    let mut vm = build_solidity(
+        r#"
+        contract foo {
+            function verify(address[] addrs, bytes[] messages, bytes[] signatures) public returns (bool[]) {
+                bool[] res = new bool[](addrs.length);
+
+                for (uint32 i = 0; i < addrs.length; i++) {
+                    res[i] = signatureVerify(addrs[i], messages[i], signatures[i]);
+                }
+
+                return res;
+            }
+        }"#,
+    );
+
+    let data_account = vm.initialize_data_account();
+    vm.function("new")
+        .accounts(vec![("dataAccount", data_account)])
+        .call();
 
-    let mut ed25519_instruction = bincode::serialize(&offsets).unwrap();
-    ed25519_instruction.extend_from_slice(signature);
-    ed25519_instruction.extend_from_slice(public_key);
-    ed25519_instruction.extend_from_slice(message);
-
-    let instr = Instructions {
-        num_instructions: 1,
-        instruction_offset: 4,
-        num_accounts: 0,
-        program_id: "Ed25519SigVerify111111111111111111111111111"
-            .from_base58()
-            .unwrap()
-            .try_into()
-            .unwrap(),
-        instruction_len: ed25519_instruction.len() as u16,
+    let mut csprng = OsRng;
+    let keys: Vec<SigningKey> = (0..4).map(|_| SigningKey::generate(&mut csprng)).collect();
+
+    let messages: [&[u8]; 4] = [
+        b"first message",
+        b"second message, signed by the second key",
+        b"third message, signed by the first key again",
+        b"fourth message, in another instruction",
+    ];
+
+    // (key, message)
+    let signed = [(0, 0), (1, 1), (0, 2), (2, 3)];
+
+    let public_keys: Vec<[u8; 32]> = keys.iter().map(|k| k.verifying_key().to_bytes()).collect();
+    let signatures: Vec<Vec<u8>> = signed
+        .iter()
+        .map(|(key, message)| keys[*key].sign(messages[*message]).to_bytes().to_vec())
+        .collect();
+
+    let sig = |no: usize| {
+        let (key, message) = signed[no];
+        (
+            &public_keys[key][..],
+            &signatures[no][..],
+            messages[message],
+        )
     };
 
-    let mut instructions = bincode::serialize(&instr).unwrap();
+    // three signatures in the first instruction, where the first key signs two messages so
+    // looking up its second signature has to probe past the first, then an instruction for
+    // another program, and another ed25519 instruction
+    let instructions = encode_ed25519_instructions(&[
+        Some(vec![sig(0), sig(1), sig(2)]),
+        None,
+        Some(vec![sig(3)]),
+    ]);
+
+    let instructions_account: Account = "Sysvar1nstructions1111111111111111111111111"
+        .from_base58()
+        .unwrap()
+        .try_into()
+        .unwrap();
+
+    vm.account_data.insert(
+        instructions_account,
+        AccountState {
+            data: instructions,
+            owner: None,
+            lamports: 0,
+        },
+    );
+
+    // (key, message, signature, expected)
+    let checks = [
+        (0, 0, 0, true),
+        (1, 1, 1, true),
+        (0, 2, 2, true),
+        (2, 3, 3, true),
+        // the first key did not sign the second message
+        (0, 1, 1, false),
+        // the first key signed the third message with another signature
+        (0, 2, 0, false),
+        // the fourth key signed nothing
+        (3, 0, 0, false),
+    ];
+
+    // every call after the first reuses the index
+    let returns = vm
+        .function("verify")
+        .arguments(&[
+            BorshToken::Array(
+                checks
+                    .iter()
+                    .map(|(key, ..)| BorshToken::Address(public_keys[*key]))
+                    .collect(),
+            ),
+            BorshToken::Array(
+                checks
+                    .iter()
+                    .map(|(_, message, ..)| BorshToken::Bytes(messages[*message].to_vec()))
+                    .collect(),
+            ),
+            BorshToken::Array(
+                checks
+                    .iter()
+                    .map(|(_, _, signature, _)| BorshToken::Bytes(signatures[*signature].clone()))
+                    .collect(),
+            ),
+        ])
+        .accounts(vec![("SysvarInstruction", instructions_account)])
+        .call()
+        .unwrap();
+
+    assert_eq!(
+        returns,
+        BorshToken::Array(
+            checks
+                .iter()
+                .map(|(.., expected)| BorshToken::Bool(*expected))
+                .collect()
+        )
+    );
+}
+
+fn encode_instructions(public_key: &[u8], signature: &[u8], message: &[u8]) -> Vec<u8> {
+    encode_ed25519_instructions(&[Some(vec![(public_key, signature, message)])])
+}
+
+/// Encode an instructions sysvar. Each entry is either an ed25519 program instruction with the
+/// given (public key, signature, message) signatures, or None for an instruction for another
+/// program.
+fn encode_ed25519_instructions(instructions: &[Option<Vec<(&[u8], &[u8], &[u8])>>]) -> Vec<u8> {
+    let mut encoded = Vec::new();
+
+    for (instr_no, sigs) in instructions.iter().enumerate() {
+        let (program_id, instruction) = if let Some(sigs) = sigs {
+            let header_len = 2 + sigs.len() * size_of::<Ed25519SignatureOffsets>();
+            let mut offsets = vec![sigs.len() as u8, 0];
+            let mut payload = Vec::new();
+
+            for (public_key, signature, message) in sigs {
+                let signature_offset = (header_len + payload.len()) as u16;
+                payload.extend_from_slice(signature);
+                let public_key_offset = (header_len + payload.len()) as u16;
+                payload.extend_from_slice(public_key);
+                let message_data_offset = (header_len + payload.len()) as u16;
+                payload.extend_from_slice(message);
+
+                let offset = Ed25519SignatureOffsets {
+                    signature_offset,
+                    signature_instruction_index: instr_no as u16,
+                    public_key_offset,
+                    public_key_instruction_index: instr_no as u16,
+                    message_data_offset,
+                    message_data_size: message.len() as u16,
+                    message_instruction_index: instr_no as u16,
+                };
+
+                offsets.extend(bincode::serialize(&offset).unwrap());
+            }
+
+            offsets.extend(payload);
+
+            let program_id: [u8; 32] = "Ed25519SigVerify111111111111111111111111111"
+                .from_base58()
+                .unwrap()
+                .try_into()
+                .unwrap();
+
+            (program_id, offsets)
+        } else {
+            ([7; 32], vec![1, 2, 3])
+        };
+
+        let instr = Instruction {
+            num_accounts: 0,
+            program_id,
+            instruction_len: instruction.len() as u16,
+        };
+
+        encoded.push(bincode::serialize(&instr).unwrap());
+        encoded.last_mut().unwrap().extend(instruction);
+    }
+
+    // the number of instructions and the offset of each
+    let mut offset = 2 + 2 * instructions.len();
+    let mut instructions_sysvar = (instructions.len() as u16).to_le_bytes().to_vec();
+
+    for instr in &encoded {
+        instructions_sysvar.extend((offset as u16).to_le_bytes());
+        offset += instr.len();
+    }
 
-    instructions.extend_from_slice(&ed25519_instruction);
+    for instr in encoded {
+        instructions_sysvar.extend(instr);
+    }
 
-    instructions
+    instructions_sysvar
 }
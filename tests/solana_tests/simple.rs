@@ -1,8 +1,12 @@
 // SPDX-License-Identifier: Apache-2.0
 
-use crate::{build_solidity, BorshToken};
+use crate::{build_solidity, BorshToken, VirtualMachineBuilder};
 use num_bigint::BigInt;
-use solang::{file_resolver::FileResolver, Target};
+use solang::{
+    codegen::{OptimizationLevel, Options},
+    file_resolver::FileResolver,
+    Target,
+};
 use std::ffi::OsStr;
 
 #[test]
@@ -666,3 +670,41 @@ fn overloading() {
         }
     );
 }
+
+#[test]
+fn heap_size() {
+    // 40000 bytes does not fit in the default 32 KiB heap
+    let mut vm = VirtualMachineBuilder::new(
+        r#"
+        contract foo {
+            function test() public returns (uint32) {
+                bytes b = new bytes(40000);
+                b[39999] = 1;
+                return b.length + uint32(uint8(b[39999]));
+            }
+        }"#,
+    )
+    .opts(Options {
+        opt_level: OptimizationLevel::Default,
+        log_runtime_errors: true,
+        log_prints: true,
+        solana_heap_size: Some(65536),
+        ..Default::default()
+    })
+    .build();
+
+    let data_account = vm.initialize_data_account();
+    vm.function("new")
+        .accounts(vec![("dataAccount", data_account)])
+        .call();
+
+    let returns = vm.function("test").call().unwrap();
+
+    assert_eq!(
+        returns,
+        BorshToken::Uint {
+            width: 32,
+            value: BigInt::from(40001)
+        }
+    );
+}
@@ -29,6 +29,7 @@ fn parse_and_codegen(src: &'static str) -> Namespace {
         #[cfg(feature = "wasm_opt")]
         wasm_opt: None,
         soroban_version: None,
+        solana_heap_size: None,
     };
 
     codegen(&mut ns, &opt);